@@ -0,0 +1,456 @@
+// json-cpp-bench: throughput, allocation and memory figures for the main
+// operations over generated and checked-in corpora.
+//
+//   json-cpp-bench [--filter TEXT] [--min-time SECONDS] [--out FILE]
+//
+// Every benchmark runs its operation until --min-time has passed (at
+// least three times) and reports ns/op, MB/s of JSON text and heap
+// allocations per op. --out writes the results as JSON for comparison
+// across commits.
+
+#include <json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#ifndef JSON_CPP_BENCH_CORPUS
+#define JSON_CPP_BENCH_CORPUS "bench/corpus"
+#endif
+
+
+static std::atomic<uint64_t> g_allocs(0);
+
+void* operator new(size_t size)
+{
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+// std::pmr::new_delete_resource(), which backs every Value, allocates
+// through the aligned overloads.
+void* operator new(size_t size, std::align_val_t align)
+{
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  size_t alignment = std::max((size_t)align, sizeof(void*));
+  size             = (std::max(size, (size_t)1) + alignment - 1) / alignment * alignment;
+  if (void *ptr = std::aligned_alloc(alignment, size))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept
+{
+  std::free(ptr);
+}
+
+
+struct Corpus
+{
+  std::string name;
+  std::string text;
+  // Representative property names and indices for the lookup benchmark.
+  std::function<size_t(const Json::Value &val)> lookup;
+};
+
+struct Result
+{
+  std::string name;
+  size_t      bytes;
+  uint64_t    iterations;
+  double      ns_per_op;
+  double      allocs_per_op;
+};
+
+static volatile size_t g_sink;
+
+
+static std::string gen_numbers(std::mt19937_64 &rng)
+{
+  std::uniform_real_distribution<double> real(-1e6, 1e6);
+  std::ostringstream                     out;
+
+  out.precision(17);
+  out << '[';
+  for (int i = 0; i < 200000; ++i) {
+    if (i)
+      out << ',';
+    switch (i % 4)
+    {
+    case 0:  out << (int64_t)(rng() % 1000);            break;
+    case 1:  out << (int64_t)rng();                     break;
+    case 2:  out << real(rng);                          break;
+    default: out << (int64_t)(rng() % 100000) << '.' << rng() % 1000 << 'e' << i % 40 - 20; break;
+    }
+  }
+  out << ']';
+  return out.str();
+}
+
+static std::string gen_strings(std::mt19937_64 &rng)
+{
+  static const char *const parts[] = {
+    "plain ascii words ", "tab\\t", "newline\\n", "quote\\\"", "slash\\\\",
+    "caf\\u00e9 ", "\\ud83d\\ude00", "na\xc3\xafve ", "\xe4\xb8\xad\xe6\x96\x87 ",
+    "\xf0\x9f\x8c\x8d ", "\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 "
+  };
+
+  std::string out = "[";
+  for (int i = 0; i < 50000; ++i) {
+    if (i)
+      out += ',';
+    out += '\"';
+    for (int n = 2 + (int)(rng() % 8); n; --n)
+      out += parts[rng() % (sizeof(parts) / sizeof(*parts))];
+    out += '\"';
+  }
+  out += ']';
+  return out;
+}
+
+static std::string gen_nested(std::mt19937_64 &)
+{
+  std::string one;
+  for (int i = 0; i < 500; ++i)
+    one += i % 2 ? "{\"a\":" : "[";
+  one += "1";
+  for (int i = 499; i >= 0; --i)
+    one += i % 2 ? "}" : "]";
+
+  std::string out = "[";
+  for (int i = 0; i < 200; ++i) {
+    if (i)
+      out += ',';
+    out += one;
+  }
+  out += ']';
+  return out;
+}
+
+static std::string gen_wide(std::mt19937_64 &rng)
+{
+  std::string out = "{";
+  for (int i = 0; i < 50000; ++i) {
+    if (i)
+      out += ',';
+    out += "\"property_" + std::to_string(i) + "\":" + std::to_string(rng() % 100000);
+  }
+  out += '}';
+  return out;
+}
+
+static std::string gen_records(std::mt19937_64 &rng)
+{
+  static const char *const cities[] = {
+    "Lisbon", "Oslo", "Kyoto", "Z\xc3\xbcrich", "Montr\xc3\xa9" "al", "Austin"
+  };
+
+  std::ostringstream out;
+  out << "[\n";
+  for (int i = 0; i < 40000; ++i) {
+    out
+      << (i ? ",\n" : "")
+      << "  {\"id\": " << i
+      << ", \"name\": \"user " << rng() % 1000000 << "\""
+      << ", \"email\": \"user" << i << "@example.com\""
+      << ", \"active\": " << (rng() % 2 ? "true" : "false")
+      << ", \"score\": " << (double)(rng() % 100000) / 1000.0
+      << ", \"tags\": [\"t" << rng() % 50 << "\", \"t" << rng() % 50 << "\"]"
+      << ", \"address\": {\"city\": \"" << cities[rng() % 6] << "\""
+      << ", \"zip\": \"" << 10000 + rng() % 90000 << "\", \"geo\": null}}";
+  }
+  out << "\n]\n";
+  return out.str();
+}
+
+
+static size_t lookup_wide(const Json::Value &val)
+{
+  size_t sum = 0;
+  for (int i = 0; i < 50000; i += 7)
+    sum += (size_t)val["property_" + std::to_string(i)].GetInt();
+  return sum;
+}
+
+static size_t lookup_records(const Json::Value &val)
+{
+  size_t sum = 0;
+  for (size_t i = 0; i < 40000; i += 3) {
+    const Json::Value &rec = val[i];
+    sum += (size_t)rec["id"].GetInt();
+    sum += rec["address"]["city"].GetType();
+  }
+  return sum;
+}
+
+static size_t lookup_config(const Json::Value &val)
+{
+  return
+    (size_t)val["listen"]["port"].GetInt() +
+    (size_t)val["limits"]["rate"]["burst"].GetInt() +
+    val["routes"][3]["cache"]["ttl"].GetType();
+}
+
+
+static std::vector<Corpus> make_corpora()
+{
+  std::mt19937_64     rng(20240601);
+  std::vector<Corpus> corpora;
+
+  corpora.push_back({ "numbers", gen_numbers(rng), nullptr });
+  corpora.push_back({ "strings", gen_strings(rng), nullptr });
+  corpora.push_back({ "nested",  gen_nested(rng),  nullptr });
+  corpora.push_back({ "wide",    gen_wide(rng),    lookup_wide });
+  corpora.push_back({ "records", gen_records(rng), lookup_records });
+
+  std::error_code ec;
+  for (
+    const auto &entry : std::filesystem::directory_iterator(JSON_CPP_BENCH_CORPUS, ec)
+  ) {
+    if (entry.path().extension() != ".json")
+      continue;
+
+    std::ifstream      file(entry.path(), std::ios::binary);
+    std::ostringstream text;
+    text << file.rdbuf();
+
+    std::string name = entry.path().stem().string();
+    corpora.push_back({
+      name, text.str(), name == "config" ? lookup_config : nullptr
+    });
+  }
+
+  return corpora;
+}
+
+
+static Result measure(
+  const std::string &name, size_t bytes, double min_time,
+  const std::function<void()> &op
+)
+{
+  using Clock = std::chrono::steady_clock;
+
+  op();
+
+  uint64_t    iterations = 0;
+  uint64_t    allocs     = g_allocs.load();
+  Clock::time_point first = Clock::now();
+  Clock::time_point last  = first;
+
+  while (
+    iterations < 3 || std::chrono::duration<double>(last - first).count() < min_time
+  ) {
+    op();
+    ++iterations;
+    last = Clock::now();
+  }
+
+  double ns = std::chrono::duration<double, std::nano>(last - first).count();
+  return {
+    name, bytes, iterations,
+    ns / (double)iterations,
+    (double)(g_allocs.load() - allocs) / (double)iterations
+  };
+}
+
+static long peak_rss_kb()
+{
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return -1;
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+#else
+  return -1;
+#endif
+}
+
+
+static void run_corpus(
+  const Corpus &corpus, const std::string &filter, double min_time,
+  std::vector<Result> &results
+)
+{
+  const std::string &text = corpus.text;
+  const size_t       size = text.size();
+
+  const auto bench = [&](const char *op, const std::function<void()> &fn)
+  {
+    std::string name = corpus.name + "/" + op;
+    if (!filter.empty() && name.find(filter) == std::string::npos)
+      return;
+
+    Result res = measure(name, size, min_time, fn);
+    std::printf(
+      "%-24s %12.0f ns/op %10.1f MB/s %12.1f allocs/op\n",
+      res.name.c_str(), res.ns_per_op,
+      res.bytes ? (double)res.bytes * 1e3 / res.ns_per_op : 0.0,
+      res.allocs_per_op
+    );
+    results.push_back(res);
+  };
+
+  Json doc;
+  if (doc.LoadFromString(text) != Json::ERR::SUCCESS) {
+    std::fprintf(stderr, "%s: corpus does not parse\n", corpus.name.c_str());
+    return;
+  }
+
+  std::filesystem::path dir  = std::filesystem::temp_directory_path();
+  std::filesystem::path src  = dir / ("json-cpp-bench-" + corpus.name + ".json");
+  std::filesystem::path dest = dir / ("json-cpp-bench-" + corpus.name + ".out.json");
+  std::ofstream(src, std::ios::binary) << text;
+
+  bench("load", [&]
+  {
+    Json json;
+    json.LoadFromString(text);
+    g_sink = json.GetData().GetType();
+  });
+  bench("validate", [&]
+  {
+    g_sink = Json::ValidateString(text);
+  });
+  bench("serialize", [&]
+  {
+    g_sink = doc.Serialize().size();
+  });
+  bench("load_file", [&]
+  {
+    Json json;
+    json.LoadFromFile(src);
+    g_sink = json.GetData().GetType();
+  });
+  bench("save_file", [&]
+  {
+    g_sink = doc.SerializeToFile(dest);
+  });
+  const std::string cbor = doc.SerializeBinary(Json::FORMAT::CBOR);
+  bench("load_cbor", [&]
+  {
+    Json json;
+    json.LoadFromBinary(cbor, Json::FORMAT::CBOR);
+    g_sink = json.GetData().GetType();
+  });
+  bench("serialize_cbor", [&]
+  {
+    g_sink = doc.SerializeBinary(Json::FORMAT::CBOR).size();
+  });
+  bench("copy", [&]
+  {
+    Json::Value copy(doc.GetData());
+    g_sink = copy.GetType();
+  });
+  if (corpus.lookup) {
+    bench("lookup", [&]
+    {
+      g_sink = corpus.lookup(doc.GetData());
+    });
+  }
+
+  std::error_code ec;
+  std::filesystem::remove(src, ec);
+  std::filesystem::remove(dest, ec);
+}
+
+
+static bool write_results(const std::string &path, const std::vector<Result> &results)
+{
+  Json::ListType list;
+  for (const Result &res : results) {
+    list.push_back(Json::Value({
+      Json::Property("name",          res.name),
+      Json::Property("bytes",         (int64_t)res.bytes),
+      Json::Property("iterations",    (int64_t)res.iterations),
+      Json::Property("ns_per_op",     res.ns_per_op),
+      Json::Property("mb_per_s",      (double)res.bytes * 1e3 / res.ns_per_op),
+      Json::Property("allocs_per_op", res.allocs_per_op)
+    }));
+  }
+
+  Json json;
+  json.Load(Json::Value({
+    Json::Property("peak_rss_kb", (int64_t)peak_rss_kb()),
+    Json::Property("benchmarks",  Json::Value(std::move(list)))
+  }));
+  return json.SerializeToFile(path);
+}
+
+
+int main(int argc, char **argv)
+{
+  std::string filter;
+  std::string out;
+  double      min_time = 0.5;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--filter" && i + 1 < argc) {
+      filter = argv[++i];
+    }
+    else if (arg == "--min-time" && i + 1 < argc) {
+      min_time = std::atof(argv[++i]);
+    }
+    else if (arg == "--out" && i + 1 < argc) {
+      out = argv[++i];
+    }
+    else {
+      std::fprintf(
+        stderr, "usage: %s [--filter TEXT] [--min-time SECONDS] [--out FILE]\n",
+        argv[0]
+      );
+      return 2;
+    }
+  }
+
+  std::vector<Result> results;
+  for (const Corpus &corpus : make_corpora()) {
+    std::printf(
+      "# %s: %.2f MB\n", corpus.name.c_str(), (double)corpus.text.size() / 1e6
+    );
+    run_corpus(corpus, filter, min_time, results);
+  }
+  std::printf("# peak RSS: %ld KB\n", peak_rss_kb());
+
+  if (!out.empty() && !write_results(out, results)) {
+    std::fprintf(stderr, "cannot write %s\n", out.c_str());
+    return 1;
+  }
+  return 0;
+}
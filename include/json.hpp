@@ -4,6 +4,19 @@
 
 #include "../json-cpp/json.hpp"
 #include "../json-cpp/property.hpp"
+#include "../json-cpp/tape.hpp"
+#include "../json-cpp/lazy.hpp"
+#include "../json-cpp/snapshot.hpp"
+#include "../json-cpp/handler.hpp"
+#include "../json-cpp/writer.hpp"
+#include "../json-cpp/stream_parser.hpp"
+#include "../json-cpp/lines.hpp"
+#include "../json-cpp/key_table.hpp"
+#include "../json-cpp/pointer.hpp"
+#include "../json-cpp/projection.hpp"
+#include "../json-cpp/reader.hpp"
+#include "../json-cpp/emitter.hpp"
+#include "../json-cpp/bind.hpp"
 
 
 #endif // !INCLUDE_JSON_HPP
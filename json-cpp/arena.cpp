@@ -0,0 +1,78 @@
+#include "arena.hpp"
+
+#include <new>
+
+
+Json::Arena::Arena(size_t block_size) :
+  m_block(0), m_cur(nullptr), m_end(nullptr), m_block_size(block_size)
+{}
+
+Json::Arena::~Arena()
+{
+  for (auto &block : m_blocks)
+    ::operator delete(block.data);
+}
+
+
+void Json::Arena::Reset()
+{
+  m_block = 0;
+  if (m_blocks.empty()) {
+    m_cur = m_end = nullptr;
+    return;
+  }
+
+  m_cur = m_blocks[0].data;
+  m_end = m_blocks[0].data + m_blocks[0].size;
+}
+
+
+void* Json::Arena::do_allocate(size_t bytes, size_t align)
+{
+  const auto aligned = [&](char *ptr)
+  {
+    return (char*)(((uintptr_t)ptr + align - 1) & ~(uintptr_t)(align - 1));
+  };
+
+  if (m_cur) {
+    char *ptr = aligned(m_cur);
+    if (ptr + bytes <= m_end) {
+      m_cur = ptr + bytes;
+      return ptr;
+    }
+  }
+
+  while (m_cur && m_block + 1 < m_blocks.size()) {
+    Block &block = m_blocks[++m_block];
+
+    m_cur = block.data;
+    m_end = block.data + block.size;
+
+    char *ptr = aligned(m_cur);
+    if (ptr + bytes <= m_end) {
+      m_cur = ptr + bytes;
+      return ptr;
+    }
+  }
+
+  size_t size = m_blocks.empty() ? m_block_size : m_blocks.back().size * 2;
+  if (size < bytes + align)
+    size = bytes + align;
+
+  m_blocks.push_back({ (char*)::operator new(size), size });
+  m_block = m_blocks.size() - 1;
+  m_cur   = m_blocks.back().data;
+  m_end   = m_blocks.back().data + size;
+
+  char *ptr = aligned(m_cur);
+  m_cur = ptr + bytes;
+  return ptr;
+}
+
+void Json::Arena::do_deallocate(void *, size_t, size_t)
+{}
+
+bool Json::Arena::do_is_equal(const memory_resource &other) const noexcept
+{
+  return this == &other;
+}
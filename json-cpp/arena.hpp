@@ -0,0 +1,45 @@
+#ifndef SOURCE_ARENA_HPP
+#define SOURCE_ARENA_HPP
+
+
+#include "json.hpp"
+
+
+// Bump allocator backing Json in ALLOC::ARENA mode. Deallocation is a
+// no-op; Reset() rewinds to the first block and keeps every block for
+// reuse by the next document.
+class Json::Arena : public std::pmr::memory_resource
+{
+public:
+
+  explicit Arena(size_t block_size = 64 * 1024);
+  ~Arena();
+
+  Arena(const Arena &arena)            = delete;
+  Arena& operator=(const Arena &arena) = delete;
+
+  void Reset();
+
+private:
+
+  struct Block
+  {
+    char   *data;
+    size_t  size;
+  };
+
+  std::vector<Block> m_blocks;
+  size_t             m_block;
+  char              *m_cur;
+  char              *m_end;
+  size_t             m_block_size;
+
+
+  void* do_allocate  (size_t bytes, size_t align)           override;
+  void  do_deallocate(void *ptr, size_t bytes, size_t align) override;
+  bool  do_is_equal  (const memory_resource &other)   const noexcept override;
+
+};
+
+
+#endif // !SOURCE_ARENA_HPP
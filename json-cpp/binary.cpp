@@ -0,0 +1,685 @@
+#include "binary.hpp"
+#include "property.hpp"
+#include "handler.hpp"
+#include "dom_builder.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+
+static constexpr size_t  StreamBufferSize = 64 * 1024;
+static constexpr uint8_t CborBreak        = 0xFF;
+
+
+class Json::Binary::Encoder
+{
+public:
+
+  Encoder(FORMAT format, std::string &out, std::ostream *stream) :
+    m_cbor(format == FORMAT::CBOR), m_out(out), m_stream(stream)
+  {}
+
+  bool Write(const Value &val)
+  {
+    put_value(val);
+    flush();
+    return !m_stream || !m_stream->fail();
+  }
+
+private:
+
+  bool          m_cbor;
+  std::string  &m_out;
+  std::ostream *m_stream;
+
+
+  void flush()
+  {
+    if (!m_stream)
+      return;
+
+    m_stream->write(m_out.data(), m_out.size());
+    m_out.clear();
+  }
+
+  // Writes lead followed by the size low bytes of arg, most significant
+  // first.
+  void put_head(uint8_t lead, uint64_t arg, size_t size)
+  {
+    char buf[9];
+    buf[0] = (char)lead;
+    for (size_t i = 0; i < size; ++i)
+      buf[1 + i] = (char)(arg >> (8 * (size - 1 - i)));
+    m_out.append(buf, 1 + size);
+  }
+
+  void put_cbor_head(uint8_t major, uint64_t arg)
+  {
+    major <<= 5;
+    if (arg < 24)
+      put_head(major | (uint8_t)arg, 0, 0);
+    else if (arg <= 0xFF)
+      put_head(major | 24, arg, 1);
+    else if (arg <= 0xFFFF)
+      put_head(major | 25, arg, 2);
+    else if (arg <= 0xFFFFFFFF)
+      put_head(major | 26, arg, 4);
+    else
+      put_head(major | 27, arg, 8);
+  }
+
+  // Sizes below fix_max fit in the low bits of fix; larger ones follow
+  // lead16 in two bytes or lead16 + 1 in four.
+  void put_msgpack_size(uint8_t fix, size_t fix_max, uint8_t lead16, uint64_t size)
+  {
+    if (size < fix_max)
+      put_head(fix | (uint8_t)size, 0, 0);
+    else if (size <= 0xFFFF)
+      put_head(lead16, size, 2);
+    else
+      put_head(lead16 + 1, size, 4);
+  }
+
+  void put_int(int64_t val)
+  {
+    if (m_cbor) {
+      if (val >= 0)
+        put_cbor_head(0, (uint64_t)val);
+      else
+        put_cbor_head(1, ~(uint64_t)val);
+      return;
+    }
+
+    if (val >= 0) {
+      if (val < 0x80)
+        put_head((uint8_t)val, 0, 0);
+      else if (val <= 0xFF)
+        put_head(0xCC, (uint64_t)val, 1);
+      else if (val <= 0xFFFF)
+        put_head(0xCD, (uint64_t)val, 2);
+      else if (val <= 0xFFFFFFFF)
+        put_head(0xCE, (uint64_t)val, 4);
+      else
+        put_head(0xCF, (uint64_t)val, 8);
+    }
+    else {
+      if (val >= -32)
+        put_head((uint8_t)val, 0, 0);
+      else if (val >= INT8_MIN)
+        put_head(0xD0, (uint64_t)val, 1);
+      else if (val >= INT16_MIN)
+        put_head(0xD1, (uint64_t)val, 2);
+      else if (val >= INT32_MIN)
+        put_head(0xD2, (uint64_t)val, 4);
+      else
+        put_head(0xD3, (uint64_t)val, 8);
+    }
+  }
+
+  void put_float(double val)
+  {
+    // Converting a finite double beyond FLT_MAX to float is undefined.
+    if (std::fabs(val) <= FLT_MAX || !std::isfinite(val)) {
+      float single = (float)val;
+      if ((double)single == val) {
+        uint32_t bits;
+        std::memcpy(&bits, &single, sizeof(bits));
+        put_head(m_cbor ? 0xFA : 0xCA, bits, 4);
+        return;
+      }
+    }
+
+    uint64_t bits;
+    std::memcpy(&bits, &val, sizeof(bits));
+    put_head(m_cbor ? 0xFB : 0xCB, bits, 8);
+  }
+
+  void put_string(std::string_view str)
+  {
+    if (m_cbor)
+      put_cbor_head(3, str.size());
+    else if (str.size() >= 32 && str.size() <= 0xFF)
+      put_head(0xD9, str.size(), 1);
+    else
+      put_msgpack_size(0xA0, 32, 0xDA, str.size());
+    m_out.append(str.data(), str.size());
+  }
+
+  void put_value(const Value &val)
+  {
+    switch (val.GetType())
+    {
+    case Null:
+      put_head(m_cbor ? 0xF6 : 0xC0, 0, 0);
+      break;
+    case Bool:
+      put_head(m_cbor ? 0xF4 + val.GetBool() : 0xC2 + val.GetBool(), 0, 0);
+      break;
+    case Int:
+      put_int(val.GetInt());
+      break;
+    case Float:
+      put_float(val.GetFloat());
+      break;
+    case String:
+      put_string(val.GetStringView());
+      break;
+    case List: {
+      const ListType &list = val.GetListRef();
+      if (m_cbor)
+        put_cbor_head(4, list.size());
+      else
+        put_msgpack_size(0x90, 16, 0xDC, list.size());
+
+      for (const Value &item : list)
+        put_value(item);
+      break;
+    }
+    case Struct: {
+      const StructType &props = val.GetStructRef();
+      if (m_cbor)
+        put_cbor_head(5, props.size());
+      else
+        put_msgpack_size(0x80, 16, 0xDE, props.size());
+
+      for (const Property &prop : props) {
+        put_string(prop.GetNameView());
+        put_value(prop.GetValue());
+      }
+      break;
+    }
+    }
+
+    if (m_stream && m_out.size() >= StreamBufferSize)
+      flush();
+  }
+
+};
+
+
+template <typename Handler>
+class Json::Binary::Decoder
+{
+public:
+
+  Decoder(std::string_view data, FORMAT format, Handler *handler) :
+    m_cur((const uint8_t*)data.data()), m_last(m_cur + data.size()),
+    m_cbor(format == FORMAT::CBOR), m_handler(handler), m_aborted(false),
+    m_budget(data.size())
+  {}
+
+  bool Decode();
+  bool Aborted() const { return m_aborted; }
+
+private:
+
+  enum Item
+  {
+    FAIL,
+    SCALAR,
+    OPENED
+  };
+
+  struct Frame
+  {
+    uint64_t left;
+    size_t   count;
+    bool     is_struct;
+    bool     indefinite;
+    // At the start of an element or member, before its key.
+    bool     between;
+  };
+
+  const uint8_t      *m_cur;
+  const uint8_t      *m_last;
+  bool                m_cbor;
+  Handler            *m_handler;
+  bool                m_aborted;
+  size_t              m_budget;
+  std::vector<Frame>  m_stack;
+  std::string         m_scratch;
+
+
+  size_t left() const { return (size_t)(m_last - m_cur); }
+
+  bool abort()
+  {
+    m_aborted = true;
+    return false;
+  }
+
+  Item emit(bool ok) { return ok ? SCALAR : (abort(), FAIL); }
+
+  bool read_uint  (size_t size, uint64_t &out);
+  bool read_head  (uint8_t info, uint64_t &arg);
+  bool take       (uint64_t size, std::string_view &out);
+  bool read_chunks(uint8_t lead, std::string_view &out);
+  bool read_key   (std::string_view &out);
+  Item open       (bool is_struct, uint64_t size, bool indefinite);
+  Item read_cbor   ();
+  Item read_msgpack();
+
+  static double to_float      (uint64_t bits, size_t size);
+  static double half_to_double(uint16_t half);
+
+};
+
+
+template <typename Handler>
+bool Json::Binary::Decoder<Handler>::Decode()
+{
+  Frame *top = nullptr;
+
+  for (;;) {
+    if (
+      top && top->between &&
+      (top->indefinite ? m_cur != m_last && *m_cur == CborBreak : top->left == 0)
+    ) {
+      m_cur += top->indefinite;
+
+      bool ok = top->is_struct ?
+        m_handler->EndStruct(top->count) : m_handler->EndList(top->count);
+      m_stack.pop_back();
+      top = m_stack.empty() ? nullptr : &m_stack.back();
+      if (!ok)
+        return abort();
+    }
+    else {
+      if (top && top->is_struct && top->between) {
+        std::string_view key;
+        if (!read_key(key))
+          return false;
+        if (!m_handler->Key(key))
+          return abort();
+        top->between = false;
+      }
+
+      Item item = m_cbor ? read_cbor() : read_msgpack();
+      if (item == FAIL)
+        return false;
+      if (item == OPENED) {
+        top = &m_stack.back();
+        continue;
+      }
+    }
+
+    // A value is complete.
+    if (!top)
+      return m_cur == m_last;
+
+    ++top->count;
+    top->left   -= !top->indefinite;
+    top->between = true;
+  }
+}
+
+
+template <typename Handler>
+bool Json::Binary::Decoder<Handler>::read_uint(size_t size, uint64_t &out)
+{
+  if (left() < size)
+    return false;
+
+  out = 0;
+  for (size_t i = 0; i < size; ++i)
+    out = (out << 8) | m_cur[i];
+  m_cur += size;
+  return true;
+}
+
+// The argument of a CBOR head: info itself below 24, then the following
+// 1, 2, 4 or 8 bytes.
+template <typename Handler>
+bool Json::Binary::Decoder<Handler>::read_head(uint8_t info, uint64_t &arg)
+{
+  if (info < 24) {
+    arg = info;
+    return true;
+  }
+
+  return info < 28 && read_uint((size_t)1 << (info - 24), arg);
+}
+
+template <typename Handler>
+bool Json::Binary::Decoder<Handler>::take(uint64_t size, std::string_view &out)
+{
+  if (size > left())
+    return false;
+
+  out    = std::string_view((const char*)m_cur, (size_t)size);
+  m_cur += size;
+  return true;
+}
+
+// Joins the chunks of an indefinite-length CBOR string, which must be
+// definite strings of the same major type, in the scratch buffer.
+template <typename Handler>
+bool Json::Binary::Decoder<Handler>::read_chunks(uint8_t lead, std::string_view &out)
+{
+  m_scratch.clear();
+  for (;;) {
+    if (m_cur == m_last)
+      return false;
+
+    uint8_t chunk_lead = *m_cur++;
+    if (chunk_lead == CborBreak)
+      break;
+
+    uint64_t         size;
+    std::string_view chunk;
+    if (
+      (chunk_lead & 0xE0) != (lead & 0xE0) ||
+      !read_head(chunk_lead & 0x1F, size) || !take(size, chunk)
+    ) {
+      return false;
+    }
+    m_scratch.append(chunk.data(), chunk.size());
+  }
+
+  out = m_scratch;
+  return true;
+}
+
+template <typename Handler>
+bool Json::Binary::Decoder<Handler>::read_key(std::string_view &out)
+{
+  uint64_t size;
+
+  if (!m_cbor) {
+    if (m_cur == m_last)
+      return false;
+
+    uint8_t lead = *m_cur++;
+    if (lead >= 0xA0 && lead <= 0xBF)
+      size = lead & 0x1F;
+    else if (lead >= 0xD9 && lead <= 0xDB)
+      return read_uint((size_t)1 << (lead - 0xD9), size) && take(size, out);
+    else if (lead >= 0xC4 && lead <= 0xC6)
+      return read_uint((size_t)1 << (lead - 0xC4), size) && take(size, out);
+    else
+      return false;
+
+    return take(size, out);
+  }
+
+  for (;;) {
+    if (m_cur == m_last)
+      return false;
+
+    uint8_t lead  = *m_cur++;
+    uint8_t major = lead >> 5;
+    uint8_t info  = lead & 0x1F;
+
+    if (major == 6) {
+      if (!read_head(info, size))
+        return false;
+      continue;
+    }
+    if (major != 2 && major != 3)
+      return false;
+    if (info == 31)
+      return read_chunks(lead, out);
+
+    return read_head(info, size) && take(size, out);
+  }
+}
+
+
+// Each element takes at least a byte, which bounds the size of a valid
+// container by the rest of the input.
+template <typename Handler>
+typename Json::Binary::Decoder<Handler>::Item
+Json::Binary::Decoder<Handler>::open(bool is_struct, uint64_t size, bool indefinite)
+{
+  if (!indefinite && size > left() / (is_struct ? 2 : 1))
+    return FAIL;
+  if (m_stack.size() == MaxDepth)
+    return FAIL;
+
+  m_stack.push_back({ size, 0, is_struct, indefinite, true });
+  if (!(is_struct ? m_handler->StartStruct() : m_handler->StartList()))
+    return abort(), FAIL;
+
+  // Reservations are drawn from a budget of one element per input byte,
+  // which valid input never exceeds, so nested containers announcing
+  // sizes they do not hold cannot reserve more than the input is worth.
+  if constexpr (std::is_same_v<Handler, DomBuilder>) {
+    size_t count = (size_t)std::min<uint64_t>(size, m_budget);
+    m_budget -= count;
+    m_handler->Reserve(count);
+  }
+  return OPENED;
+}
+
+template <typename Handler>
+typename Json::Binary::Decoder<Handler>::Item
+Json::Binary::Decoder<Handler>::read_cbor()
+{
+  for (;;) {
+    if (m_cur == m_last)
+      return FAIL;
+
+    uint8_t  lead  = *m_cur++;
+    uint8_t  major = lead >> 5;
+    uint8_t  info  = lead & 0x1F;
+    uint64_t arg;
+
+    if (major == 7) {
+      switch (info)
+      {
+      case 20: return emit(m_handler->Bool(false));
+      case 21: return emit(m_handler->Bool(true));
+      case 22:
+      case 23: return emit(m_handler->Null());
+      case 25:
+        if (!read_uint(2, arg))
+          return FAIL;
+        return emit(m_handler->Float(half_to_double((uint16_t)arg)));
+      case 26:
+      case 27:
+        if (!read_uint(info == 26 ? 4 : 8, arg))
+          return FAIL;
+        return emit(m_handler->Float(to_float(arg, info == 26 ? 4 : 8)));
+      default:
+        return FAIL;
+      }
+    }
+
+    if (info == 31) {
+      std::string_view str;
+      switch (major)
+      {
+      case 2:
+      case 3:
+        if (!read_chunks(lead, str))
+          return FAIL;
+        return emit(m_handler->String(str));
+      case 4:
+      case 5:
+        return open(major == 5, 0, true);
+      default:
+        return FAIL;
+      }
+    }
+
+    if (!read_head(info, arg))
+      return FAIL;
+
+    // Integers beyond int64_t become floats, as in the text parser.
+    switch (major)
+    {
+    case 0:
+      if (arg <= INT64_MAX)
+        return emit(m_handler->Int((int64_t)arg));
+      return emit(m_handler->Float((double)arg));
+    case 1:
+      if (arg <= INT64_MAX)
+        return emit(m_handler->Int(-1 - (int64_t)arg));
+      return emit(m_handler->Float(-1.0 - (double)arg));
+    case 2:
+    case 3: {
+      std::string_view str;
+      if (!take(arg, str))
+        return FAIL;
+      return emit(m_handler->String(str));
+    }
+    case 4:
+      return open(false, arg, false);
+    case 5:
+      return open(true, arg, false);
+    default:
+      // A tag; the tagged item follows.
+      continue;
+    }
+  }
+}
+
+template <typename Handler>
+typename Json::Binary::Decoder<Handler>::Item
+Json::Binary::Decoder<Handler>::read_msgpack()
+{
+  if (m_cur == m_last)
+    return FAIL;
+
+  uint8_t lead = *m_cur++;
+
+  if (lead <= 0x7F)
+    return emit(m_handler->Int(lead));
+  if (lead >= 0xE0)
+    return emit(m_handler->Int((int8_t)lead));
+  if (lead <= 0x8F)
+    return open(true, lead & 0x0F, false);
+  if (lead <= 0x9F)
+    return open(false, lead & 0x0F, false);
+
+  uint64_t         arg;
+  std::string_view str;
+
+  if (lead <= 0xBF) {
+    if (!take(lead & 0x1F, str))
+      return FAIL;
+    return emit(m_handler->String(str));
+  }
+
+  switch (lead)
+  {
+  case 0xC0: return emit(m_handler->Null());
+  case 0xC2: return emit(m_handler->Bool(false));
+  case 0xC3: return emit(m_handler->Bool(true));
+  case 0xC4:
+  case 0xC5:
+  case 0xC6:
+  case 0xD9:
+  case 0xDA:
+  case 0xDB:
+    if (
+      !read_uint((size_t)1 << (lead - (lead >= 0xD9 ? 0xD9 : 0xC4)), arg) ||
+      !take(arg, str)
+    ) {
+      return FAIL;
+    }
+    return emit(m_handler->String(str));
+  case 0xCA:
+  case 0xCB:
+    if (!read_uint(lead == 0xCA ? 4 : 8, arg))
+      return FAIL;
+    return emit(m_handler->Float(to_float(arg, lead == 0xCA ? 4 : 8)));
+  case 0xCC:
+  case 0xCD:
+  case 0xCE:
+  case 0xCF:
+    if (!read_uint((size_t)1 << (lead - 0xCC), arg))
+      return FAIL;
+    if (arg <= INT64_MAX)
+      return emit(m_handler->Int((int64_t)arg));
+    return emit(m_handler->Float((double)arg));
+  case 0xD0:
+  case 0xD1:
+  case 0xD2:
+  case 0xD3: {
+    size_t size = (size_t)1 << (lead - 0xD0);
+    if (!read_uint(size, arg))
+      return FAIL;
+    // Sign-extend from size bytes.
+    size_t shift = 64 - 8 * size;
+    return emit(m_handler->Int((int64_t)(arg << shift) >> shift));
+  }
+  case 0xDC:
+  case 0xDD:
+    if (!read_uint(lead == 0xDC ? 2 : 4, arg))
+      return FAIL;
+    return open(false, arg, false);
+  case 0xDE:
+  case 0xDF:
+    if (!read_uint(lead == 0xDE ? 2 : 4, arg))
+      return FAIL;
+    return open(true, arg, false);
+  default:
+    return FAIL;
+  }
+}
+
+
+template <typename Handler>
+double Json::Binary::Decoder<Handler>::to_float(uint64_t bits, size_t size)
+{
+  if (size == 4) {
+    uint32_t single_bits = (uint32_t)bits;
+    float    single;
+    std::memcpy(&single, &single_bits, sizeof(single));
+    return single;
+  }
+
+  double val;
+  std::memcpy(&val, &bits, sizeof(val));
+  return val;
+}
+
+template <typename Handler>
+double Json::Binary::Decoder<Handler>::half_to_double(uint16_t half)
+{
+  int    exp  = (half >> 10) & 0x1F;
+  int    mant = half & 0x3FF;
+  double val;
+
+  if (exp == 0)
+    val = std::ldexp(mant, -24);
+  else if (exp != 31)
+    val = std::ldexp(mant + 1024, exp - 25);
+  else
+    val = mant == 0 ? INFINITY : NAN;
+
+  return half & 0x8000 ? -val : val;
+}
+
+
+void Json::Binary::Encode(const Value &val, FORMAT format, std::string &out)
+{
+  Encoder(format, out, nullptr).Write(val);
+}
+
+bool Json::Binary::Encode(const Value &val, FORMAT format, std::ostream &stream)
+{
+  std::string buf;
+  buf.reserve(StreamBufferSize);
+  return Encoder(format, buf, &stream).Write(val);
+}
+
+
+Json::ERR Json::Binary::Decode(std::string_view data, FORMAT format, Handler &handler)
+{
+  Decoder<Handler> decoder(data, format, &handler);
+  if (decoder.Decode())
+    return ERR::SUCCESS;
+
+  return decoder.Aborted() ? ERR::ABORTED : ERR::BAD_JSON;
+}
+
+bool Json::Binary::Decode(std::string_view data, FORMAT format, DomBuilder &builder)
+{
+  return Decoder<DomBuilder>(data, format, &builder).Decode();
+}
@@ -0,0 +1,41 @@
+#ifndef SOURCE_BINARY_HPP
+#define SOURCE_BINARY_HPP
+
+
+#include "json.hpp"
+
+#include <ostream>
+#include <string>
+#include <string_view>
+
+
+// CBOR (RFC 8949) and MessagePack encoding of Values. Ints, floats,
+// strings, lists and structs map to the formats' own types; floats that
+// survive the round trip through a float are written in four bytes.
+//
+// Decoding walks the input with an explicit stack and reports the same
+// events as the text parser, with the same Json::MaxDepth limit on
+// nesting; strings reach the handler as views into the input. Byte strings are read as
+// strings, CBOR tags are ignored and undefined reads as null. Struct keys
+// must be strings; extension types, non-string keys, truncated input and
+// trailing bytes are errors.
+class Json::Binary
+{
+public:
+
+  static void Encode(const Value &val, FORMAT format, std::string  &out);
+  static bool Encode(const Value &val, FORMAT format, std::ostream &stream);
+
+  static ERR  Decode(std::string_view data, FORMAT format, Handler    &handler);
+  static bool Decode(std::string_view data, FORMAT format, DomBuilder &builder);
+
+private:
+
+  class Encoder;
+  template <typename Handler>
+  class Decoder;
+
+};
+
+
+#endif // !SOURCE_BINARY_HPP
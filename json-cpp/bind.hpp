@@ -0,0 +1,431 @@
+#ifndef SOURCE_BIND_HPP
+#define SOURCE_BIND_HPP
+
+
+#include "json.hpp"
+#include "value.hpp"
+#include "reader.hpp"
+#include "emitter.hpp"
+#include "mapped_file.hpp"
+
+#include <map>
+#include <array>
+#include <tuple>
+#include <limits>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <optional>
+#include <utility>
+#include <type_traits>
+
+
+// Reads and writes C++ types directly, without building a Value. A struct
+// is bound by listing its members at global scope:
+//
+//   struct User { int64_t id; std::string name; std::vector<std::string> tags; };
+//   JSON_CPP_BIND(User, id, name, tags)
+//
+//   User user;
+//   if (Json::Read(text, user) != Json::ERR::SUCCESS) ...
+//   std::string out = Json::Write(user);
+//
+// Unknown keys are skipped and missing ones leave their member as it is.
+// Members may be bool, arithmetic types, std::string, Value, bound structs
+// and std::vector, std::optional (null) or std::map<std::string, ...> of
+// these; other types are added by specializing Codec. Keys that differ
+// from the member names need a Binding written out:
+//
+//   template <> struct Json::Binding<User> {
+//     static constexpr auto Fields = std::make_tuple(
+//       Json::Field{ "user_id", &User::id }, Json::Field{ "name", &User::name }
+//     );
+//   };
+template <typename Class, typename Member>
+struct Json::Field
+{
+  std::string_view  name;
+  Member Class::   *member;
+
+  constexpr Field(std::string_view name, Member Class::*member) :
+    name(name), member(member)
+  {}
+};
+
+
+template <>
+struct Json::Codec<bool>
+{
+  static bool Read (Reader  &reader,  bool &out) { return reader.ReadBool(out); }
+  static void Write(Emitter &emitter, bool  val) { emitter.Bool(val); }
+};
+
+
+template <typename T>
+struct Json::Codec<T, std::enable_if_t<std::is_integral_v<T>>>
+{
+  static bool Read(Reader &reader, T &out)
+  {
+    if constexpr (std::is_signed_v<T>) {
+      int64_t val;
+      if (!reader.ReadInt(val, std::numeric_limits<T>::min(), std::numeric_limits<T>::max()))
+        return false;
+      out = (T)val;
+    }
+    else {
+      uint64_t val;
+      if (!reader.ReadUInt(val, std::numeric_limits<T>::max()))
+        return false;
+      out = (T)val;
+    }
+    return true;
+  }
+
+  static void Write(Emitter &emitter, T val)
+  {
+    if constexpr (std::is_signed_v<T>)
+      emitter.Int(val);
+    else
+      emitter.UInt(val);
+  }
+};
+
+
+template <typename T>
+struct Json::Codec<T, std::enable_if_t<std::is_floating_point_v<T>>>
+{
+  static bool Read(Reader &reader, T &out)
+  {
+    // Narrowing a double beyond the range of T is undefined.
+    double max = std::numeric_limits<double>::infinity();
+    if constexpr (sizeof(T) < sizeof(double))
+      max = (double)std::numeric_limits<T>::max();
+
+    double val;
+    if (!reader.ReadFloat(val, max))
+      return false;
+
+    out = (T)val;
+    return true;
+  }
+
+  static void Write(Emitter &emitter, T val) { emitter.Float((double)val); }
+};
+
+
+template <>
+struct Json::Codec<std::string>
+{
+  static bool Read(Reader &reader, std::string &out)
+  {
+    std::string_view val;
+    if (!reader.ReadString(val))
+      return false;
+
+    out.assign(val);
+    return true;
+  }
+
+  static void Write(Emitter &emitter, const std::string &val) { emitter.String(val); }
+};
+
+
+template <>
+struct Json::Codec<Json::Value>
+{
+  static bool Read (Reader  &reader,  Value       &out) { return reader.ReadValue(out); }
+  static void Write(Emitter &emitter, const Value &val) { emitter.Write(val); }
+};
+
+
+template <typename T, typename Alloc>
+struct Json::Codec<std::vector<T, Alloc>>
+{
+  static bool Read(Reader &reader, std::vector<T, Alloc> &out)
+  {
+    if (!reader.StartList())
+      return false;
+
+    out.clear();
+    while (reader.NextElement()) {
+      // std::vector<bool> hands out proxies, not references.
+      if constexpr (std::is_same_v<T, bool>) {
+        bool item;
+        if (!Codec<bool>::Read(reader, item))
+          return false;
+        out.push_back(item);
+      }
+      else {
+        out.emplace_back();
+        if (!Codec<T>::Read(reader, out.back()))
+          return false;
+      }
+    }
+    return !reader.Failed();
+  }
+
+  static void Write(Emitter &emitter, const std::vector<T, Alloc> &val)
+  {
+    emitter.StartList();
+    for (const auto &item : val)
+      Codec<T>::Write(emitter, item);
+    emitter.EndList();
+  }
+};
+
+
+template <typename T>
+struct Json::Codec<std::optional<T>>
+{
+  static bool Read(Reader &reader, std::optional<T> &out)
+  {
+    if (reader.ReadNull()) {
+      out.reset();
+      return true;
+    }
+    if (reader.Failed())
+      return false;
+
+    if (!out)
+      out.emplace();
+    return Codec<T>::Read(reader, *out);
+  }
+
+  static void Write(Emitter &emitter, const std::optional<T> &val)
+  {
+    if (val)
+      Codec<T>::Write(emitter, *val);
+    else
+      emitter.Null();
+  }
+};
+
+
+template <typename T, typename Compare, typename Alloc>
+struct Json::Codec<std::map<std::string, T, Compare, Alloc>>
+{
+  static bool Read(Reader &reader, std::map<std::string, T, Compare, Alloc> &out)
+  {
+    if (!reader.StartStruct())
+      return false;
+
+    out.clear();
+    for (std::string_view key; reader.NextMember(key);) {
+      // The key only lives until the next read.
+      if (!Codec<T>::Read(reader, out[std::string(key)]))
+        return false;
+    }
+    return !reader.Failed();
+  }
+
+  static void Write(Emitter &emitter, const std::map<std::string, T, Compare, Alloc> &val)
+  {
+    emitter.StartStruct();
+    for (const auto &[key, item] : val) {
+      emitter.Key(key);
+      Codec<T>::Write(emitter, item);
+    }
+    emitter.EndStruct();
+  }
+};
+
+
+// Members are matched against a constexpr table of the names; the one
+// after the previous match is tried first, so keys in declaration order
+// cost one comparison each.
+template <typename T>
+struct Json::Codec<T, std::void_t<decltype(Json::Binding<T>::Fields)>>
+{
+  static bool Read(Reader &reader, T &out)
+  {
+    if (!reader.StartStruct())
+      return false;
+
+    size_t hint = 0;
+    for (std::string_view key; reader.NextMember(key);) {
+      size_t i = find(key, hint);
+      if (i == Count) {
+        if (!reader.Skip())
+          return false;
+        continue;
+      }
+
+      if (!read(reader, out, i, Indices()))
+        return false;
+      hint = i + 1 < Count ? i + 1 : 0;
+    }
+    return !reader.Failed();
+  }
+
+  static void Write(Emitter &emitter, const T &val)
+  {
+    emitter.StartStruct();
+    write(emitter, val, Indices());
+    emitter.EndStruct();
+  }
+
+private:
+
+  static constexpr size_t Count =
+    std::tuple_size_v<std::decay_t<decltype(Binding<T>::Fields)>>;
+
+  using Indices = std::make_index_sequence<Count>;
+
+  template <size_t... I>
+  static constexpr std::array<std::string_view, Count> names(std::index_sequence<I...>)
+  {
+    return { std::get<I>(Binding<T>::Fields).name... };
+  }
+
+  static constexpr std::array<std::string_view, Count> Names = names(Indices());
+
+
+  static size_t find(std::string_view key, size_t hint)
+  {
+    if constexpr (Count == 0)
+      return Count;
+
+    if (Names[hint] == key)
+      return hint;
+
+    for (size_t i = 0; i < Count; ++i) {
+      if (i != hint && Names[i] == key)
+        return i;
+    }
+    return Count;
+  }
+
+  template <size_t I>
+  static bool read_field(Reader &reader, T &out)
+  {
+    const auto &field = std::get<I>(Binding<T>::Fields);
+    using Member = std::decay_t<decltype(out.*field.member)>;
+    return Codec<Member>::Read(reader, out.*field.member);
+  }
+
+  template <size_t... I>
+  static bool read(Reader &reader, T &out, size_t i, std::index_sequence<I...>)
+  {
+    bool ok = false;
+    ((i == I && (ok = read_field<I>(reader, out), true)) || ...);
+    return ok;
+  }
+
+  template <size_t... I>
+  static void write(Emitter &emitter, const T &val, std::index_sequence<I...>)
+  {
+    auto write_field = [&](const auto &field) {
+      using Member = std::decay_t<decltype(val.*field.member)>;
+      emitter.Key(field.name);
+      Codec<Member>::Write(emitter, val.*field.member);
+    };
+    (write_field(std::get<I>(Binding<T>::Fields)), ...);
+  }
+};
+
+
+template <typename T>
+Json::ERR Json::Read(std::string_view json_str, T &out)
+{
+  Reader reader(json_str);
+  return Codec<T>::Read(reader, out) && reader.Finish() ? ERR::SUCCESS : ERR::BAD_JSON;
+}
+
+template <typename T>
+Json::ERR Json::Read(std::string_view json_str, T &out, std::string &log)
+{
+  Reader reader(json_str);
+  if (Codec<T>::Read(reader, out) && reader.Finish())
+    return ERR::SUCCESS;
+
+  log = reader.GetLog();
+  return ERR::BAD_JSON;
+}
+
+template <typename T>
+Json::ERR Json::ReadFile(const std::filesystem::path &path, T &out)
+{
+  MappedFile file;
+  if (!file.Open(path))
+    return ERR::BAD_PATH;
+
+  return Read(file.GetData(), out);
+}
+
+template <typename T>
+std::string Json::Write(const T &val)
+{
+  std::string out;
+  Emitter emitter(out);
+  Codec<T>::Write(emitter, val);
+  return out;
+}
+
+template <typename T>
+bool Json::WriteFile(const std::filesystem::path &path, const T &val)
+{
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return false;
+
+  std::string out = Write(val);
+  file.write(out.data(), out.size());
+  file.close();
+  return !file.fail();
+}
+
+
+#define JSON_CPP_EXPAND(x) x
+#define JSON_CPP_CAT(a, b) JSON_CPP_CAT_I(a, b)
+#define JSON_CPP_CAT_I(a, b) a##b
+#define JSON_CPP_COUNT(...) \
+  JSON_CPP_EXPAND(JSON_CPP_COUNT_N(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define JSON_CPP_COUNT_N(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+#define JSON_CPP_MAP(m, t, ...) \
+  JSON_CPP_EXPAND(JSON_CPP_CAT(JSON_CPP_MAP_, JSON_CPP_COUNT(__VA_ARGS__))(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_1(m, t, x) m(t, x)
+#define JSON_CPP_MAP_2(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_1(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_3(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_2(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_4(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_3(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_5(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_4(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_6(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_5(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_7(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_6(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_8(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_7(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_9(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_8(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_10(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_9(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_11(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_10(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_12(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_11(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_13(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_12(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_14(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_13(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_15(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_14(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_16(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_15(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_17(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_16(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_18(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_17(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_19(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_18(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_20(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_19(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_21(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_20(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_22(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_21(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_23(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_22(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_24(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_23(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_25(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_24(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_26(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_25(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_27(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_26(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_28(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_27(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_29(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_28(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_30(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_29(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_31(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_30(m, t, __VA_ARGS__))
+#define JSON_CPP_MAP_32(m, t, x, ...) m(t, x), JSON_CPP_EXPAND(JSON_CPP_MAP_31(m, t, __VA_ARGS__))
+
+#define JSON_CPP_FIELD(Type, member) Json::Field<Type, decltype(Type::member)>{ #member, &Type::member }
+
+// Binds up to 32 members of Type under their own names. Must be used at
+// global scope.
+#define JSON_CPP_BIND(Type, ...)                                          \
+  template <> struct Json::Binding<Type> {                                \
+    static constexpr auto Fields = std::make_tuple(                       \
+      JSON_CPP_MAP(JSON_CPP_FIELD, Type, __VA_ARGS__)                     \
+    );                                                                    \
+  };
+
+
+#endif // !SOURCE_BIND_HPP
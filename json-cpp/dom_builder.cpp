@@ -0,0 +1,149 @@
+#include "dom_builder.hpp"
+#include "property.hpp"
+#include "key_table.hpp"
+
+
+Json::DomBuilder::DomBuilder(
+  Value *root, std::pmr::memory_resource *res, KeyTable *keys
+) :
+  m_res(res), m_keys(keys), m_root(root), m_slot(nullptr)
+{}
+
+
+bool Json::DomBuilder::Null()
+{
+  next();
+  return true;
+}
+
+bool Json::DomBuilder::Bool(bool val)
+{
+  Value *slot  = next();
+  slot->m_type = Json::Bool;
+  slot->m_bool = val;
+  return true;
+}
+
+bool Json::DomBuilder::Int(int64_t val)
+{
+  Value *slot  = next();
+  slot->m_type = Json::Int;
+  slot->m_int  = val;
+  return true;
+}
+
+bool Json::DomBuilder::Float(double val)
+{
+  Value *slot   = next();
+  slot->m_type  = Json::Float;
+  slot->m_float = val;
+  return true;
+}
+
+bool Json::DomBuilder::String(std::string_view str)
+{
+  Value *slot   = next();
+  slot->m_value = Value::create<StringType>(m_res, str, m_res);
+  slot->m_type  = Json::String;
+  return true;
+}
+
+bool Json::DomBuilder::Key(std::string_view key)
+{
+  StructType &props = ((Value::StructData*)m_stack.back()->m_value)->props;
+
+  if (m_keys && key.size() > Property::InlineSize)
+    props.push_back(Property(m_keys->Intern(key), nullptr, Value()));
+  else
+    props.push_back(Property(key, m_res, Value()));
+  m_slot = &props.back().m_value;
+  return true;
+}
+
+
+bool Json::DomBuilder::StartList()
+{
+  Value *slot   = next();
+  slot->m_value = Value::create<ListType>(m_res, m_res);
+  slot->m_type  = Json::List;
+  m_stack.push_back(slot);
+  return true;
+}
+
+bool Json::DomBuilder::EndList(size_t)
+{
+  m_stack.pop_back();
+  return true;
+}
+
+bool Json::DomBuilder::StartStruct()
+{
+  Value *slot   = next();
+  slot->m_value = Value::create<Value::StructData>(m_res, m_res);
+  slot->m_type  = Json::Struct;
+  m_stack.push_back(slot);
+  return true;
+}
+
+bool Json::DomBuilder::EndStruct(size_t)
+{
+  m_stack.pop_back();
+  return true;
+}
+
+
+void Json::DomBuilder::Reserve(size_t count)
+{
+  Value *top = m_stack.back();
+  if (top->m_type == Json::List)
+    ((ListType*)top->m_value)->reserve(count);
+  else
+    ((Value::StructData*)top->m_value)->props.reserve(count);
+}
+
+
+void Json::DomBuilder::Join(std::vector<Value> &parts)
+{
+  Value &dst = parts[0];
+
+  if (dst.m_type == Json::List) {
+    ListType &list  = *(ListType*)dst.m_value;
+    size_t    total = 0;
+
+    for (Value &part : parts)
+      total += ((ListType*)part.m_value)->size();
+    list.reserve(total);
+
+    for (size_t i = 1; i < parts.size(); ++i)
+      for (Value &val : *(ListType*)parts[i].m_value)
+        list.push_back(std::move(val));
+    return;
+  }
+
+  Value::StructData *data  = (Value::StructData*)dst.m_value;
+  size_t             total = 0;
+
+  for (Value &part : parts)
+    total += ((Value::StructData*)part.m_value)->props.size();
+  data->props.reserve(total);
+
+  for (size_t i = 1; i < parts.size(); ++i)
+    for (Property &prop : ((Value::StructData*)parts[i].m_value)->props)
+      data->props.push_back(std::move(prop));
+}
+
+
+Json::Value* Json::DomBuilder::next()
+{
+  if (m_stack.empty())
+    return m_root;
+
+  Value *top = m_stack.back();
+  if (top->m_type == Json::List) {
+    ListType *list = (ListType*)top->m_value;
+    list->emplace_back();
+    return &list->back();
+  }
+
+  return m_slot;
+}
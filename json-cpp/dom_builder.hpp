@@ -0,0 +1,61 @@
+#ifndef SOURCE_DOM_BUILDER_HPP
+#define SOURCE_DOM_BUILDER_HPP
+
+
+#include "json.hpp"
+#include "value.hpp"
+#include "handler.hpp"
+
+#include <string_view>
+
+
+// Handler that builds a Value tree. Containers are created as soon as
+// they open, so every nested value is constructed in place inside its
+// parent's storage. Declared final so Parser<DomBuilder> calls it
+// directly rather than through the vtable.
+class Json::DomBuilder final : public Json::Handler
+{
+public:
+
+  // With a key table, property names too long to be stored inline are
+  // interned in it.
+  DomBuilder(
+    Value *root, std::pmr::memory_resource *res = std::pmr::get_default_resource(),
+    KeyTable *keys = nullptr
+  );
+
+  bool Null  ()                     override;
+  bool Bool  (bool             val) override;
+  bool Int   (int64_t          val) override;
+  bool Float (double           val) override;
+  bool String(std::string_view str) override;
+  bool Key   (std::string_view key) override;
+
+  bool StartList  ()             override;
+  bool EndList    (size_t count) override;
+  bool StartStruct()             override;
+  bool EndStruct  (size_t count) override;
+
+  // Makes room for count elements or members in the container that has
+  // just been started.
+  void Reserve(size_t count);
+
+  // Moves the elements or members of parts[1..] onto the end of parts[0];
+  // all parts must be containers of the same type.
+  static void Join(std::vector<Value> &parts);
+
+private:
+
+  std::pmr::memory_resource *m_res;
+  KeyTable                  *m_keys;
+  Value                     *m_root;
+  std::vector<Value*>        m_stack;
+  Value                     *m_slot;
+
+
+  Value* next();
+
+};
+
+
+#endif // !SOURCE_DOM_BUILDER_HPP
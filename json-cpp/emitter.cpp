@@ -0,0 +1,104 @@
+#include "emitter.hpp"
+#include "number.hpp"
+
+#include <cmath>
+#include <charconv>
+
+
+Json::Emitter::Emitter(std::string &out) :
+  m_writer(out), m_comma(false)
+{}
+
+
+void Json::Emitter::Null()
+{
+  separate();
+  m_writer.put(std::string_view("null"));
+}
+
+void Json::Emitter::Bool(bool val)
+{
+  separate();
+  m_writer.put(val ? std::string_view("true") : std::string_view("false"));
+}
+
+void Json::Emitter::Int(int64_t val)
+{
+  separate();
+  char buf[Number::MaxSize];
+  m_writer.put(buf, Number::Format(val, buf));
+}
+
+void Json::Emitter::UInt(uint64_t val)
+{
+  separate();
+  char buf[Number::MaxSize];
+  m_writer.put(buf, std::to_chars(buf, buf + sizeof(buf), val).ptr - buf);
+}
+
+void Json::Emitter::Float(double val)
+{
+  separate();
+  if (!std::isfinite(val)) {
+    m_writer.put(std::string_view("null"));
+    return;
+  }
+
+  char buf[Number::MaxSize];
+  m_writer.put(buf, Number::Format(val, buf));
+}
+
+void Json::Emitter::String(std::string_view val)
+{
+  separate();
+  m_writer.put_string(val);
+}
+
+void Json::Emitter::Write(const Value &val)
+{
+  separate();
+  m_writer.Write(val);
+}
+
+void Json::Emitter::Key(std::string_view name)
+{
+  separate();
+  m_writer.put_string(name);
+  m_writer.put(':');
+  m_comma = false;
+}
+
+
+void Json::Emitter::StartList()
+{
+  separate();
+  m_writer.put('[');
+  m_comma = false;
+}
+
+void Json::Emitter::EndList()
+{
+  m_writer.put(']');
+  m_comma = true;
+}
+
+void Json::Emitter::StartStruct()
+{
+  separate();
+  m_writer.put('{');
+  m_comma = false;
+}
+
+void Json::Emitter::EndStruct()
+{
+  m_writer.put('}');
+  m_comma = true;
+}
+
+
+void Json::Emitter::separate()
+{
+  if (m_comma)
+    m_writer.put(',');
+  m_comma = true;
+}
@@ -0,0 +1,58 @@
+#ifndef SOURCE_EMITTER_HPP
+#define SOURCE_EMITTER_HPP
+
+
+#include "json.hpp"
+#include "writer.hpp"
+
+#include <string>
+#include <string_view>
+
+
+// Push serializer, the counterpart of Reader: values are appended to the
+// string as they are emitted and commas are placed between them.
+//
+//   emitter.StartStruct();
+//   emitter.Key("id");
+//   emitter.Int(id);
+//   emitter.EndStruct();
+//
+// The calls are not checked; a struct member must be a Key followed by
+// one value.
+class Json::Emitter
+{
+public:
+
+  explicit Emitter(std::string &out);
+
+  Emitter(const Emitter &emitter)            = delete;
+  Emitter& operator=(const Emitter &emitter) = delete;
+
+  void Null  ();
+  void Bool  (bool             val);
+  void Int   (int64_t          val);
+  void UInt  (uint64_t         val);
+  // Infinities and NaN are written as null.
+  void Float (double           val);
+  void String(std::string_view val);
+  void Write (const Value     &val);
+  void Key   (std::string_view name);
+
+  void StartList  ();
+  void EndList    ();
+  void StartStruct();
+  void EndStruct  ();
+
+private:
+
+  Writer  m_writer;
+  // A value was written at the current level, so the next one needs a ','.
+  bool    m_comma;
+
+
+  void separate();
+
+};
+
+
+#endif // !SOURCE_EMITTER_HPP
@@ -0,0 +1,38 @@
+#ifndef SOURCE_HANDLER_HPP
+#define SOURCE_HANDLER_HPP
+
+
+#include "json.hpp"
+
+#include <string_view>
+
+
+// Receives parse events from Json::ParseString/ParseFile in document
+// order. Struct members arrive as Key() followed by the value. Returning
+// false from any event stops the parse with ERR::ABORTED. Strings are only
+// valid for the duration of the call.
+class Json::Handler
+{
+public:
+
+  static constexpr bool Decode = true;
+  static constexpr bool Filter = false;
+
+  virtual ~Handler() = default;
+
+  virtual bool Null  ()                 { return true; }
+  virtual bool Bool  (bool)             { return true; }
+  virtual bool Int   (int64_t)          { return true; }
+  virtual bool Float (double)           { return true; }
+  virtual bool String(std::string_view) { return true; }
+  virtual bool Key   (std::string_view) { return true; }
+
+  virtual bool StartList  ()       { return true; }
+  virtual bool EndList    (size_t) { return true; }
+  virtual bool StartStruct()       { return true; }
+  virtual bool EndStruct  (size_t) { return true; }
+
+};
+
+
+#endif // !SOURCE_HANDLER_HPP
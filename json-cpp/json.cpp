@@ -1,1017 +1,659 @@
 #include "json.hpp"
 #include "property.hpp"
+#include "parser.hpp"
+#include "dom_builder.hpp"
+#include "handler.hpp"
+#include "writer.hpp"
+#include "arena.hpp"
+#include "mapped_file.hpp"
+#include "scanner.hpp"
+#include "thread_pool.hpp"
+#include "key_table.hpp"
+#include "projection.hpp"
+#include "binary.hpp"
 
-#include <wchar.h>
-#include <stdexcept>
 #include <cstdint>
 #include <fstream>
 #include <filesystem>
-#include <filesystem>
-#include <locale>
+#include <memory>
+
+
+static constexpr size_t ParallelMinSize = 1024 * 1024;
+static constexpr size_t PiecesPerThread = 4;
 
 
 bool Json::ValidateString(const std::string &json_string)
 {
-  return ValidateString(
-    std::wstring(json_string.begin(), json_string.end())
-  );
+  return validate(json_string);
 }
 
 bool Json::ValidateString(const std::wstring &json_string)
 {
-  return validate(json_string);
+  return validate(to_str(json_string));
 }
 
 bool Json::ValidateString(const std::string &json_string, std::string &log)
 {
-  return ValidateString(
-    std::wstring(json_string.begin(), json_string.end()),
-    log
-  );
+  return validate(json_string, &log);
 }
 
 bool Json::ValidateString(const std::wstring &json_string, std::string &log)
 {
-  return validate(json_string, &log);
+  return validate(to_str(json_string), &log);
+}
+
+bool Json::ValidateString(const char *data, size_t size)
+{
+  return validate(std::string_view(data, size));
+}
+
+bool Json::ValidateString(const char *data, size_t size, std::string &log)
+{
+  return validate(std::string_view(data, size), &log);
 }
 
 Json::ERR Json::ValidateFile(const std::filesystem::path &path)
 {
-  std::wstring json_str;
-  if (!read_file(json_str, path))
+  MappedFile file;
+  if (!file.Open(path))
     return ERR::BAD_PATH;
 
-  return validate(json_str) ? Json::ERR::SUCCESS : Json::ERR::BAD_JSON;
+  return validate(file.GetData()) ? Json::ERR::SUCCESS : Json::ERR::BAD_JSON;
 }
 
 Json::ERR Json::ValidateFile(const std::filesystem::path &path, std::string &log)
 {
-  std::wstring json_str;
-  if (!read_file(json_str, path))
+  MappedFile file;
+  if (!file.Open(path))
     return ERR::BAD_PATH;
 
-  return validate(json_str, &log) ? Json::ERR::SUCCESS : Json::ERR::BAD_JSON;
+  return validate(file.GetData(), &log) ? Json::ERR::SUCCESS : Json::ERR::BAD_JSON;
+}
+
+Json::ERR Json::ParseString(const std::string &json_string, Handler &handler)
+{
+  return parse(json_string, handler);
+}
+
+Json::ERR Json::ParseString(
+  const std::string &json_string, Handler &handler, std::string &log
+)
+{
+  return parse(json_string, handler, &log);
+}
+
+Json::ERR Json::ParseFile(const std::filesystem::path &path, Handler &handler)
+{
+  MappedFile file;
+  if (!file.Open(path))
+    return ERR::BAD_PATH;
+
+  return parse(file.GetData(), handler);
+}
+
+Json::ERR Json::ParseFile(
+  const std::filesystem::path &path, Handler &handler, std::string &log
+)
+{
+  MappedFile file;
+  if (!file.Open(path))
+    return ERR::BAD_PATH;
+
+  return parse(file.GetData(), handler, &log);
+}
+
+Json::ERR Json::ParseBinary(std::string_view data, FORMAT format, Handler &handler)
+{
+  return Binary::Decode(data, format, handler);
 }
 
 
 Json::Json() :
-  m_data(new Value())
+  m_data(new Value()), m_arena(nullptr)
+{}
+
+Json::Json(ALLOC alloc) :
+  m_data(new Value()), m_arena(alloc == ALLOC::ARENA ? new Arena() : nullptr)
 {}
 
+Json::Json(std::shared_ptr<KeyTable> keys, ALLOC alloc) :
+  Json(alloc)
+{
+  m_keys = std::move(keys);
+}
+
+Json::Json(const Json &json) :
+  m_data(nullptr), m_arena(json.m_arena ? new Arena() : nullptr),
+  m_keys(json.m_keys)
+{
+  m_data = new Value(json.GetData(), resource());
+}
+
+Json::Json(Json &&json) noexcept :
+  m_data(json.m_data), m_arena(json.m_arena), m_keys(std::move(json.m_keys))
+{
+  json.m_data  = nullptr;
+  json.m_arena = nullptr;
+}
+
 Json::~Json()
 {
   delete m_data;
+  delete m_arena;
+}
+
+
+Json& Json::operator=(const Json &json)
+{
+  if (this != &json)
+    Load(json.GetData());
+
+  return *this;
+}
+
+Json& Json::operator=(Json &&json) noexcept
+{
+  std::swap(m_data,  json.m_data);
+  std::swap(m_arena, json.m_arena);
+  std::swap(m_keys,  json.m_keys);
+  return *this;
 }
 
 
 void Json::Load(const Value &val)
 {
-  *m_data = val;
+  GetData() = Value(val, resource());
+}
+
+void Json::Load(Value &&val)
+{
+  if (!m_data)
+    m_data = new Value(std::move(val));
+  else
+    *m_data = std::move(val);
+}
+
+// A moved-from Json has no Value until it is used again.
+Json::Value& Json::GetData()
+{
+  if (!m_data)
+    m_data = new Value();
+  return *m_data;
+}
+
+const Json::Value& Json::GetData() const
+{
+  static const Value empty;
+  return m_data ? *m_data : empty;
 }
 
 Json::ERR Json::LoadFromFile(const std::filesystem::path &path)
 {
-  std::wstring json_str;
-  if (!read_file(json_str, path))
+  MappedFile file;
+  if (!file.Open(path))
     return ERR::BAD_PATH;
 
-  return LoadFromString(json_str);
+  return load(file.GetData());
 }
 
 Json::ERR Json::LoadFromString(const std::string &json_string)
 {
-  return LoadFromString(std::wstring(json_string.begin(), json_string.end()));
+  return load(json_string);
 }
 
 Json::ERR Json::LoadFromString(const std::wstring &json_string)
 {
-  std::string validator_log;
-  if (!validate(json_string, &validator_log))
-    return ERR::BAD_JSON;
+  return LoadFromString(to_str(json_string));
+}
 
-  auto st  = json_string.begin();
-  auto end = json_string.end();
+Json::ERR Json::LoadFromFile(const std::filesystem::path &path, size_t threads)
+{
+  MappedFile file;
+  if (!file.Open(path))
+    return ERR::BAD_PATH;
 
-  while (
-    *st == L' ' || *st == L'\t' || *st == L'\r' || *st == L'\n'
-  ) {
-    ++st;
-  }
+  return load(file.GetData(), threads);
+}
 
-  while (
-    *(end - 1) == L' ' || *(end - 1) == L'\t' || *(end - 1) == L'\r' || *(end - 1) == L'\n'
-  ) {
-    --end;
-  }
+Json::ERR Json::LoadFromString(const std::string &json_string, size_t threads)
+{
+  return load(json_string, threads);
+}
 
-  deserialize_value(std::wstring(st, end), m_data);
-  return ERR::SUCCESS;
+Json::ERR Json::LoadFromFile(const std::filesystem::path &path, const Projection &projection)
+{
+  MappedFile file;
+  if (!file.Open(path))
+    return ERR::BAD_PATH;
+
+  return load(file.GetData(), projection);
+}
+
+Json::ERR Json::LoadFromString(const std::string &json_string, const Projection &projection)
+{
+  return load(json_string, projection);
+}
+
+Json::ERR Json::LoadFromBinary(std::string_view data, FORMAT format)
+{
+  return load(data, format);
+}
+
+Json::ERR Json::LoadFromBinaryFile(const std::filesystem::path &path, FORMAT format)
+{
+  MappedFile file;
+  if (!file.Open(path))
+    return ERR::BAD_PATH;
+
+  return load(file.GetData(), format);
 }
 
 std::string Json::Serialize() const
 {
-  return to_str(serialize_value(*m_data));
+  Writer writer;
+  writer.Write(GetData());
+  return writer.Release();
 }
 
 std::wstring Json::SerializeW() const
 {
-  return serialize_value(*m_data);
+  Writer writer;
+  writer.Write(GetData());
+  return to_wstr(std::string_view(writer.Data(), writer.Size()));
 }
 
 bool Json::SerializeToFile(const std::filesystem::path &path) const
 {
-  std::wofstream file(path);
-  file.imbue(std::locale("en_US.UTF-8"));
+  std::ofstream file(path, std::ios::binary);
   if (!file.is_open())
     return false;
 
-  file << SerializeW();
+  Writer(file).Write(GetData());
   file.close();
-  return true;
+  return !file.fail();
 }
 
-
-
-std::string Json::to_str(const std::wstring &wstr)
+std::string Json::SerializeBinary(FORMAT format) const
 {
-  std::string out(wstr.size(), '\0');
-  for (size_t i = 0; i < wstr.size(); ++i) {
-    if (wstr[i] > 127)
-      out[i] = '?';
-    else
-     out[i] = wstr[i];
-  }
-
+  std::string out;
+  Binary::Encode(GetData(), format, out);
   return out;
 }
 
-bool Json::read_file(std::wstring &out, const std::filesystem::path &path)
+bool Json::SerializeBinary(FORMAT format, std::ostream &stream) const
 {
-  std::wifstream file(path);
+  return Binary::Encode(GetData(), format, stream);
+}
 
-  out.clear();
+bool Json::SerializeBinaryToFile(const std::filesystem::path &path, FORMAT format) const
+{
+  std::ofstream file(path, std::ios::binary);
   if (!file.is_open())
     return false;
 
-  file.imbue(std::locale("en_US.UTF-8"));
-  for (std::wstring line; std::getline(file, line);)
-    out += line + L'\n';
-
+  Binary::Encode(GetData(), format, file);
   file.close();
-  return true;
+  return !file.fail();
 }
 
-bool Json::validate(
-  const std::wstring &json_str, std::string *log
-)
-{
-  uint64_t ln  = 1;
-  uint64_t col = 0;
-
-  auto st  = json_str.begin();
-  auto end = json_str.end();
-
-  for (; st != json_str.end(); ++st) {
-    ++col;
-
-    bool br = false;
-    switch (*st)
-    {
-    case L' ':                  break;
-    case L'\t':                 break;
-    case L'\r': col = 0;        break;
-    case L'\n': col = 0;  ++ln; break;
-    default:
-      br = true;
-      break;
-    }
-    if (br)
-      break;
-  }
 
-  if (st == json_str.end()) {
-    if (log)
-      *log = "Empty json";
-    return false;
-  }
 
-  while (
-    *(end - 1) == L' ' || *(end - 1) == L'\t' || *(end - 1) == L'\r' || *(end - 1) == L'\n'
-  ) {
-    --end;
-  }
-
-  return validate_value(
-    std::wstring(st, end), log, ln, col
-  );
-}
-
-bool Json::validate_property(
-  const std::wstring &json_str, std::string *log, uint64_t ln, uint64_t col
-)
+void Json::Reset()
 {
-  const auto make_log = [](
-    const std::string &msg, size_t ln, size_t col
-  )
-  {
-    return msg + " (ln. " + std::to_string(ln) + ", col. " + std::to_string(col) + ")";
-  };
+  if (m_data)
+    *m_data = Value();
+  else
+    m_data = new Value();
 
-  auto name_first = json_str.begin();
-  auto name_last  = json_str.end();
-  auto val_first  = json_str.end();
-  auto val_last   = json_str.end();
-
-  for (; name_first != json_str.end(); ++name_first) {
-    if (*name_first == L'\"')
-      break;
-    
-    switch (*name_first)
-    {
-    case L' ':                  break;
-    case L'\t':                 break;
-    case L'\r': col = 0;        break;
-    case L'\n': col = 0;  ++ln; break;
-    default:
-      if (log)
-        *log = make_log("Expected \'\"\'", ln, col);
-      return false;
-    }
-
-    ++col;
-  }
-
-  if (name_first == json_str.end()) {
-    if (log)
-      *log = make_log("Property is empty", ln, col);
-    return false;
-  }
-
-
-  bool esc = false;
-  ++col;
-  for (name_last = name_first + 1; name_last != json_str.end(); ++name_last) {
-    if (*name_last == L'\"' && !esc)
-      break;
-    
-    esc = *name_last == L'\\' && !esc;
-
-    switch (*name_last)
-    {
-    case L' ':                  break;
-    case L'\t':                 break;
-    case L'\r': col = 0;        break;
-    case L'\n': col = 0;  ++ln; break;
-    default:                    break;
-    }
-    ++col;
-  }
+  if (m_arena)
+    m_arena->Reset();
+}
 
-  if (name_last == json_str.end()) {
-    if (log)
-      *log = make_log("Expected \'\"\'", ln, col);
-    return false;
-  }
 
-  uint64_t name_last_ln  = ln;
-  uint64_t name_last_col = col;
-
-  ++col;
-  for (val_first = name_last + 1; val_first != json_str.end(); ++val_first) {
-    if (*val_first == L':') {
-      ++val_first;
-      if (val_first == json_str.end()) {
-        if (log)
-          *log = make_log("Expected value", ln, col);
-        return false;
-      }
-      ++col;
-      break;
-    }
 
-    switch (*val_first)
-    {
-    case L' ':                  break;
-    case L'\t':                 break;
-    case L'\r': col = 0;        break;
-    case L'\n': col = 0;  ++ln; break;
-    default:
-      if (log)
-        *log = make_log("Expected \':\'", ln, col);
-      return false;
-    }
+std::pmr::memory_resource* Json::resource() const
+{
+  if (m_arena)
+    return m_arena;
 
-    ++col;
-  }
+  return std::pmr::get_default_resource();
+}
 
-  if (val_first == json_str.end()) {
-    if (log)
-      *log = make_log("Expected \':\'", name_last_ln, name_last_col + 1);
-    return false;
-  }
+Json::ERR Json::load(std::string_view json_str, size_t threads)
+{
+  std::unique_ptr<Value> data(new Value());
 
-  while (
-    *val_first == L' ' || *val_first == L'\t' || *val_first == L'\r' || *val_first == L'\n'
+  if (
+    threads != 1 && !m_arena && json_str.size() >= ParallelMinSize &&
+    load_parallel(json_str, threads, m_keys.get(), *data)
   ) {
-    ++val_first;
-    if (val_first == json_str.end()) {
-      if (log)
-        *log = make_log("Expected value", ln, col);
-      return false;
-    }
-
-    switch (*val_first)
-    {
-    case L' ':                  break;
-    case L'\t':                 break;
-    case L'\r': col = 0;        break;
-    case L'\n': col = 0;  ++ln; break;
-    default:                    break;
-    }
-
-    ++col;
+    delete m_data;
+    m_data = data.release();
+    return ERR::SUCCESS;
   }
 
-  while (
-    *(val_last - 1) == L' ' || *(val_last - 1) == L'\t' || *(val_last - 1) == L'\r' || *(val_last - 1) == L'\n'
+  DomBuilder builder(data.get(), resource(), m_keys.get());
+  if (
+    !Parser<DomBuilder>(
+      json_str.data(), json_str.data() + json_str.size()
+    ).Parse(builder)
   ) {
-    --val_last;
+    return ERR::BAD_JSON;
   }
 
-  return validate_value(
-    std::wstring(val_first, val_last),
-    log,
-    ln,
-    col
-  );
+  delete m_data;
+  m_data = data.release();
+  return ERR::SUCCESS;
 }
 
-bool Json::validate_value(
-  const std::wstring &json_str, std::string *log, uint64_t ln, uint64_t col
-)
+Json::ERR Json::load(std::string_view json_str, const Projection &projection)
 {
-  const auto make_log = [](
-    const std::string &msg, size_t ln, size_t col
-  )
-  {
-    return msg + " (ln. " + std::to_string(ln) + ", col. " + std::to_string(col) + ")";
-  };
-
-  const auto type_error = [&]()
-  {
-    if (log)
-      *log = make_log("Unknown type", ln, col);
-    return false;
-  };
-
-
-  if (json_str == L"null") {
-    return true;
-  }
-  else if (json_str == L"false") {
-    return true;
-  }
-  else if (json_str == L"true") {
-    return true;
-  }
-  else if (
-    (json_str[0] >= L'0' && json_str[0] <= L'9') || json_str[0] == L'-' || json_str[0] == L'.'
-  ) {
-    auto is_int = [](const std::wstring &str, bool is_signed)
-    {
-      size_t i = 0;
-
-      if (str.empty() || str == L"-")
-        return false;
-
-      if (is_signed && str[0] == L'-')
-        ++i;
-
-      for (; i < str.size(); ++i)
-        if (str[i] < L'0' || str[i] > L'9')
-          return false;
+  std::unique_ptr<Value> data(new Value());
 
-      return true;
-    };
+  if (!projection.parse(json_str, data.get(), resource(), m_keys.get()))
+    return ERR::BAD_JSON;
 
-    auto is_float = [&](const std::wstring &str)
-    {
-      if (str.empty() || str == L".")
-        return false;
+  delete m_data;
+  m_data = data.release();
+  return ERR::SUCCESS;
+}
 
-      auto point = str.find(L'.');
-      if (point == str.npos)
-        point = str.size();
+Json::ERR Json::load(std::string_view input, FORMAT format)
+{
+  std::unique_ptr<Value> data(new Value());
 
-      if (point > 0) {
-        if (
-          !is_int(
-            std::wstring(str.begin(), str.begin() + point),
-            true
-          )
-        ) {
-          return false;
-        }
-      }
-      if (point < json_str.size() - 1) {
-        if (
-          !is_int(
-            std::wstring(str.begin() + point + 1, str.end()),
-            false
-          )
-        ) {
-          return false;
-        }
-      }
+  DomBuilder builder(data.get(), resource(), m_keys.get());
+  if (!Binary::Decode(input, format, builder))
+    return ERR::BAD_JSON;
 
-      return true;
-    };
+  delete m_data;
+  m_data = data.release();
+  return ERR::SUCCESS;
+}
 
+std::string Json::to_str(const std::wstring &wstr)
+{
+  std::string out;
+  out.reserve(wstr.size());
 
-    auto fi_e = json_str.find(L'e');
-    if (fi_e == json_str.npos)
-      fi_e = json_str.size();
+  for (size_t i = 0; i < wstr.size(); ++i) {
+    uint32_t cp = (uint32_t)wstr[i];
 
-    if (fi_e > 0) {
+    if constexpr (sizeof(wchar_t) == 2) {
       if (
-        !is_float(std::wstring(json_str.begin(), json_str.begin() + fi_e))
+        cp >= 0xD800 && cp <= 0xDBFF && i + 1 < wstr.size() &&
+        (uint32_t)wstr[i + 1] >= 0xDC00 && (uint32_t)wstr[i + 1] <= 0xDFFF
       ) {
-        return type_error();
-      }
-    }
-    if (fi_e < json_str.size() - 1) {
-      if (
-        !is_int(
-          std::wstring(json_str.begin() + fi_e + 1, json_str.end()),
-          true
-        )
-      ) {
-        return type_error();
+        cp = 0x10000 + ((cp - 0xD800) << 10) + ((uint32_t)wstr[++i] - 0xDC00);
       }
     }
 
-    return true;
+    char buf[4];
+    out.append(buf, encode_utf8(cp, buf));
   }
-  else if (json_str[0] == L'\"') {
-    bool quote = true;
-    bool esc   = false;
-
-    for (size_t i = 1; i < json_str.size(); ++i) {
-      if (!esc && json_str[i] == L'\"')
-        quote = !quote;
-      else if (quote)
-        esc = json_str[i] == L'\\' && !esc;
-      else {
+
+  return out;
+}
+
+std::wstring Json::to_wstr(std::string_view str)
+{
+  std::wstring out;
+  out.reserve(str.size());
+
+  for (size_t i = 0; i < str.size();) {
+    uint8_t  c   = (uint8_t)str[i];
+    uint32_t cp  = 0xFFFD;
+    size_t   len = 1;
+
+    if (c < 0x80) {
+      cp = c;
+    }
+    else if (c >= 0xC2 && c <= 0xF4) {
+      size_t   need = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : 1;
+      uint32_t res  = c & (0x3F >> need);
+
+      size_t n = 0;
+      for (; n < need && i + 1 + n < str.size(); ++n) {
+        uint8_t cc = (uint8_t)str[i + 1 + n];
+        if ((cc & 0xC0) != 0x80)
+          break;
+        res = (res << 6) | (cc & 0x3F);
+      }
+
+      if (n == need) {
+        len = need + 1;
         if (
-          json_str[i] != L' ' && json_str[i] != L'\t' && json_str[i] != L'\r' && json_str[i] != L'\n'
+          (need == 2 && res >= 0x800   && (res < 0xD800 || res > 0xDFFF)) ||
+          (need == 3 && res >= 0x10000 && res <= 0x10FFFF)                ||
+          need == 1
         ) {
-          return type_error();
+          cp = res;
         }
       }
     }
 
-    if (quote)
-      return type_error();
+    i += len;
 
-    return true;
-  }
-  else if (json_str[0] == L'[' || json_str[0] == L'{') {
-    uint64_t curly_br_c  = 0;
-    uint64_t square_br_c = 0;
-    uint64_t last_comma  = 0;
-    uint64_t ln_comma    = ln;
-    uint64_t col_comma   = col;
-    bool     str         = false;
-    bool     esc         = false;
-
-    ++col;
-    for (size_t i = 1; i < json_str.size(); ++i) {
-      if (!str) {
-        if (json_str[i] == L'{')
-          ++curly_br_c;
-        else if (json_str[i] == L'}')
-          --curly_br_c;
-        else if (json_str[i] == L'[')
-          ++square_br_c;
-        else if (json_str[i] == L']')
-          --square_br_c;
-        else if (curly_br_c == 0 && square_br_c == 0 && json_str[i] == L',') {
-          auto val_st  = json_str.begin() + last_comma + 1;
-          auto val_end = json_str.begin() + i;
-
-          uint64_t val_ln  = ln_comma;
-          uint64_t val_col = col_comma + 1;
-
-          ln_comma  = ln;
-          col_comma = col;
-
-          last_comma = i;
-
-          while (
-            *val_st == L' ' || *val_st == L'\t' || *val_st == L'\r' || *val_st == L'\n'
-          ) {
-            switch (*val_st)
-            {
-            case L' ':                          break;
-            case L'\t':                         break;
-            case L'\r': val_col = 0;            break;
-            case L'\n': val_col = 0;  ++val_ln; break;
-            default:                            break;
-            }
-
-            ++val_st;
-            ++val_col;
-          }
-          while (
-            *(val_end - 1) == L' ' || *(val_end - 1) == L'\t' || *(val_end - 1) == L'\r' || *(val_end - 1) == L'\n'
-          ) {
-            --val_end;
-          }
-
-          if (json_str[0] == L'[') {
-            if (
-              !validate_value(
-                std::wstring(val_st, val_end),
-                log,
-                val_ln,
-                val_col
-              )
-            ) {
-              return false;
-            }
-          }
-          else {
-            if (
-              !validate_property(
-                std::wstring(val_st, val_end),
-                log,
-                val_ln,
-                val_col
-              )
-            ) {
-              return false;
-            }
-          }
-        }
+    if constexpr (sizeof(wchar_t) == 2) {
+      if (cp >= 0x10000) {
+        cp -= 0x10000;
+        out.push_back((wchar_t)(0xD800 + (cp >> 10)));
+        out.push_back((wchar_t)(0xDC00 + (cp & 0x3FF)));
+        continue;
       }
+    }
+    out.push_back((wchar_t)cp);
+  }
 
-      if (!esc && json_str[i] == L'\"')
-        str = !str;
-      else if (str)
-        esc = json_str[i] == L'\\' && !esc;
-
-      switch (json_str[i])
-      {
-      case L'\t':                 break;
-      case L'\r': col = 0;        break;
-      case L'\n': col = 0;  ++ln; break;
-      default:                    break;
-      }
+  return out;
+}
 
-      ++col;
-    }
+size_t Json::encode_utf8(uint32_t cp, char *out)
+{
+  if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF)
+    cp = 0xFFFD;
+
+  if (cp < 0x80) {
+    out[0] = (char)cp;
+    return 1;
+  }
+  if (cp < 0x800) {
+    out[0] = (char)(0xC0 | (cp >> 6));
+    out[1] = (char)(0x80 | (cp & 0x3F));
+    return 2;
+  }
+  if (cp < 0x10000) {
+    out[0] = (char)(0xE0 | (cp >> 12));
+    out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[2] = (char)(0x80 | (cp & 0x3F));
+    return 3;
+  }
+
+  out[0] = (char)(0xF0 | (cp >> 18));
+  out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+  out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+  out[3] = (char)(0x80 | (cp & 0x3F));
+  return 4;
+}
 
-    if (json_str[0] == L'[') {
-      if (*(json_str.end() - 1) != L']') {
-        if (log)
-          *log = make_log("Expected ']'", ln, col);
-        return false;
-      }
-    }
-    else {
-      if (*(json_str.end() - 1) != L'}') {
-        if (log)
-          *log = make_log("Expected '}'", ln, col);
-        return false;
-      }
-    }
+bool Json::validate(
+  std::string_view json_str, std::string *log
+)
+{
+  NullHandler handler;
+  return Parser<NullHandler>(
+    json_str.data(), json_str.data() + json_str.size()
+  ).Parse(handler, log);
+}
 
-    bool is_comma = json_str[last_comma] == L',';
-    auto val_st   = json_str.begin() + last_comma + 1;
-    auto val_end  = json_str.end() - 1;
+// Finds where the body of a top-level list or struct may be cut. The body
+// is divided into `pieces` chunks scanned in parallel twice: first from
+// both possible string states to get each chunk's outcome, then, with the
+// real state at every chunk start known, for the first depth-1 comma in
+// it. bounds gets the opening bracket, those commas and the closing
+// bracket. Only strings and bracket depth are tracked; the parse of each
+// piece checks the rest.
+bool Json::split_container(
+  std::string_view json_str, ThreadPool &pool, char &type,
+  std::vector<const char*> &bounds
+)
+{
+  const char *first = Scanner::SkipWhitespace(
+    json_str.data(), json_str.data() + json_str.size()
+  );
+  const char *close = json_str.data() + json_str.size();
 
-    uint64_t val_ln  = ln_comma;
-    uint64_t val_col = col_comma + 1;
+  while (close != first && Scanner::SkipWhitespace(close - 1, close) == close)
+    --close;
 
-    while (
-      *val_st == L' ' || *val_st == L'\t' || *val_st == L'\r' || *val_st == L'\n'
-    ) {
-      switch (*val_st)
-      {
-      case L' ':                          break;
-      case L'\t':                         break;
-      case L'\r': val_col = 0;            break;
-      case L'\n': val_col = 0;  ++val_ln; break;
-      default:                            break;
-      }
+  if (close - first < 2 || (*first != '[' && *first != '{'))
+    return false;
 
-      ++val_st;
-      ++val_col;
-    }
-    while (
-      *(val_end - 1) == L' ' || *(val_end - 1) == L'\t' || *(val_end - 1) == L'\r' || *(val_end - 1) == L'\n'
-    ) {
-      --val_end;
-    }
+  type = *first;
+  if (*--close != (type == '[' ? ']' : '}'))
+    return false;
 
-    if (
-      val_end == json_str.begin() + last_comma + 1 &&
-      val_st  == json_str.end() - 1
-    ) {
-      if (is_comma) {
-        if (log) {
-          if (json_str[0] == L'[') {
-            *log = make_log(
-              "Expected value", val_ln, val_col
-            );
-          }
-          else {
-            *log = make_log(
-              "Expected property", val_ln, val_col
-            );
-          }
+  // Returns the first depth-1 comma when find_comma is set.
+  const auto scan = [](
+    const char *cur, const char *last, bool &in_string, long &depth,
+    bool find_comma
+  ) -> const char*
+  {
+    while (cur != last) {
+      if (in_string) {
+        cur = Scanner::FindQuote(cur, last);
+        if (cur == last)
+          break;
+        if (*cur == '\\') {
+          cur = last - cur > 2 ? cur + 2 : last;
+          continue;
         }
-        return false;
+        in_string = false;
+        ++cur;
+        continue;
       }
 
-      return true;
-    }
-
-    if (json_str[0] == L'[') {
-      return validate_value(
-        std::wstring(val_st, val_end),
-        log,
-        val_ln,
-        val_col
-      );
-    }
-    
-    return validate_property(
-      std::wstring(val_st, val_end),
-      log,
-      val_ln,
-      val_col
-    );
-  }
-
-  return type_error();
-}
-
-std::wstring Json::format_in(std::wstring json_str)
-{
-  if (json_str.size() < 2)
-    return json_str;
-
-  for (size_t i = 0; i < json_str.size() - 1; ++i) {
-    if (json_str[i] == L'\\') {
-      switch (json_str[i + 1])
+      switch (*cur)
       {
-      case L'\"':
-        json_str.erase(json_str.begin() + i);
-        break;
-      case L'\\':
-        json_str.erase(json_str.begin() + i);
-        break;
-      case L'/':
-        json_str.erase(json_str.begin() + i);
-        break;
-      case L'b':
-        json_str.erase(json_str.begin() + i);
-        json_str[i] = L'\b';
-        break;
-      case L'f':
-        json_str.erase(json_str.begin() + i);
-        json_str[i] = L'\f';
-        break;
-      case L'n':
-        json_str.erase(json_str.begin() + i);
-        json_str[i] = L'\n';
-        break;
-      case L'r':
-        json_str.erase(json_str.begin() + i);
-        json_str[i] = L'\r';
-        break;
-      case L't':
-        json_str.erase(json_str.begin() + i);
-        json_str[i] = L'\t';
-        break;
-      default:
+      case '\"': in_string = true; break;
+      case '[':
+      case '{': ++depth;            break;
+      case ']':
+      case '}': --depth;            break;
+      case ',':
+        if (find_comma && depth == 1)
+          return cur;
         break;
       }
+      ++cur;
     }
-  }
+    return nullptr;
+  };
 
-  return json_str;
-}
-
-std::wstring Json::format_out(std::wstring str)
-{
-  for (size_t i = 0; i < str.size(); ++i) {
-    switch (str[i])
-    {
-    case L'\"':
-    case L'\\':
-    case L'/':
-      str.insert(str.begin() + i + 1, str[i]);
-      str[i++] = L'\\';
-      break;
-    case L'\b':
-      str.insert(str.begin() + i + 1, L'b');
-      str[i++] = L'\\';
-      break;
-    case L'\f':
-      str.insert(str.begin() + i + 1, L'f');
-      str[i++] = L'\\';
-      break;
-    case L'\n':
-      str.insert(str.begin() + i + 1, L'n');
-      str[i++] = L'\\';
-      break;
-    case L'\r':
-      str.insert(str.begin() + i + 1, L'r');
-      str[i++] = L'\\';
-      break;
-    case L'\t':
-      str.insert(str.begin() + i + 1, L't');
-      str[i++] = L'\\';
-      break;
-      
-    default:
-      break;
-    }
-  }
+  struct Chunk
+  {
+    const char *first;
+    bool        end_in_string[2];
+    long        delta[2];
+    bool        in_string;
+    long        depth;
+    const char *comma;
+  };
 
-  return str;
-}
+  // Chunks never start right after a backslash, so their first byte is
+  // never escaped.
+  const size_t       body  = (size_t)(close - first - 1);
+  const size_t       count = pool.Size() * PiecesPerThread;
+  std::vector<Chunk> chunks(count + 1);
 
-std::wstring Json::serialize_property(const Json::Property &prop)
-{
-  return L"\"" + format_out(prop.GetNameW()) + L"\":" + serialize_value(prop.m_value);
-}
+  for (size_t i = 0; i <= count; ++i) {
+    const char *pos = i == count ? close : first + 1 + body * i / count;
+    while (pos != close && pos[-1] == '\\')
+      ++pos;
+    chunks[i].first = pos;
+  }
 
-std::wstring Json::serialize_value(const Json::Value &val)
-{
-  switch (val.m_type)
+  pool.Run(count, [&](size_t i)
   {
-  case Json::Bool:
-    return *(bool*)val.m_value ? L"true" : L"false";
-  case Json::Int:
-    return std::to_wstring(*(int64_t*)val.m_value);
-  case Json::Float:
-    return std::to_wstring(*(double*)val.m_value);
-  case Json::String: {
-    return L"\"" + format_out(*(std::wstring*)val.m_value) + L"\"";
-  }
-  case Json::List: {
-    std::wstring out = L"[";
-
-    if (((ListType*)val.m_value)->size() != 0) {
-      out += serialize_value(
-        *(*(ListType*)val.m_value).begin()
-      );
-      for (
-        auto it = ++((ListType*)val.m_value)->begin();
-        it != ((ListType*)val.m_value)->end();
-        ++it
-      ) {
-        out += L"," + serialize_value(*it);
-      }
+    for (int in = 0; in < 2; ++in) {
+      bool in_string = in;
+      long depth     = 0;
+      scan(chunks[i].first, chunks[i + 1].first, in_string, depth, false);
+      chunks[i].end_in_string[in] = in_string;
+      chunks[i].delta[in]         = depth;
     }
+  });
 
-    return out += L"]";
+  chunks[0].in_string = false;
+  chunks[0].depth     = 1;
+  for (size_t i = 0; i < count; ++i) {
+    chunks[i + 1].in_string = chunks[i].end_in_string[chunks[i].in_string];
+    chunks[i + 1].depth     = chunks[i].depth + chunks[i].delta[chunks[i].in_string];
   }
-  case Json::Struct: {
-    std::wstring out = L"{";
-
-    if (((StructType*)val.m_value)->size() != 0) {
-      out += serialize_property(
-        *(*(StructType*)val.m_value).begin()
-      );
-      for (
-        auto it = ++((StructType*)val.m_value)->begin();
-        it != ((StructType*)val.m_value)->end();
-        ++it
-      ) {
-        out += L"," + serialize_property(*it);
-      }
-    }
 
-    return out += L"}";
-  }
-  default:
-    return L"null";
-  }
+  pool.Run(count - 1, [&](size_t i)
+  {
+    Chunk &chunk = chunks[i + 1];
+    bool   in_string = chunk.in_string;
+    long   depth     = chunk.depth;
+    chunk.comma = scan(chunk.first, chunks[i + 2].first, in_string, depth, true);
+  });
+
+  bounds.push_back(first);
+  for (size_t i = 1; i < count; ++i)
+    if (chunks[i].comma)
+      bounds.push_back(chunks[i].comma);
+  bounds.push_back(close);
+
+  return bounds.size() > 2;
 }
 
-void Json::deserialize_property(
-  const std::wstring &json_str, Json::Property *prop
+// Parses the pieces of the top-level container between the commas found
+// by split_container() and joins them. Any piece failing to parse sends
+// the whole input back to the sequential parser, which then reports the
+// error; a split that is off for malformed input can therefore only cost
+// time, never change the result.
+bool Json::load_parallel(
+  std::string_view json_str, size_t threads, KeyTable *keys, Value &out
 )
 {
-  if (prop == nullptr || json_str.empty())
-    throw std::runtime_error(
-      "deserialize_property was called with null argument"
-    );
-
-  auto name_first   = json_str.begin();
-  auto name_last    = json_str.end();
-  auto val_first    = json_str.end();
-  auto val_last     = json_str.end();
-
-  bool esc = false;
-
-  for (; name_first != json_str.end(); ++name_first)
-    if (*name_first == L'\"')
-      break;
-  
-  for (name_last = name_first + 1; name_last != json_str.end(); ++name_last) {
-    if (*name_last == L'\"' && !esc)
-      break;
-
-    esc = *name_last == L'\\' && !esc;
-  }
+  ThreadPool pool(threads);
+  if (pool.Size() == 1)
+    return false;
 
-  for (val_first = name_last + 1; val_first != json_str.end(); ++val_first)
-    if (*val_first == L':')
-      break;
-  
-  ++val_first;
-  while (
-    *val_first == L' ' || *val_first == L'\t' || *val_first == L'\r' || *val_first == L'\n'
-  ) {
-    ++val_first;
-  }
+  char                     type;
+  std::vector<const char*> bounds;
+  if (!split_container(json_str, pool, type, bounds))
+    return false;
 
-  while (
-    *(val_last - 1) == L' ' || *(val_last - 1) == L'\t' || *(val_last - 1) == L'\r' || *(val_last - 1) == L'\n'
-  ) {
-    --val_last;
-  }
+  const size_t       count = bounds.size() - 1;
+  std::vector<Value> parts(count);
+  std::vector<char>  ok(count, 0);
 
+  pool.Run(count, [&](size_t i)
+  {
+    DomBuilder builder(&parts[i], std::pmr::get_default_resource(), keys);
+    ok[i] = Parser<DomBuilder>(
+      bounds[i] + 1, bounds[i + 1]
+    ).ParseRange(builder, type);
+  });
+
+  for (char piece_ok : ok)
+    if (!piece_ok)
+      return false;
 
-  prop->SetName(format_in(std::wstring(name_first + 1, name_last)));
-  deserialize_value(
-    std::wstring(val_first, val_last), &prop->m_value
-  );
+  DomBuilder::Join(parts);
+  out = std::move(parts[0]);
+  return true;
 }
 
-void Json::deserialize_value(
-  const std::wstring &json_str, Json::Value *val
+Json::ERR Json::parse(
+  std::string_view json_str, Handler &handler, std::string *log
 )
 {
-  if (val == nullptr || json_str.empty())
-    throw std::runtime_error(
-      "deserialize_value was called with null argument"
-    );
-
-  val->clear();
-
-  if (json_str == L"null") {
-    *val = Json::Value();
-  }
-  else if (json_str == L"false") {
-    *val = Json::Value(false);
-  }
-  else if (json_str == L"true") {
-    *val = Json::Value(true);
-  }
-  else if (
-    (json_str[0] >= L'0' && json_str[0] <= L'9') || json_str[0] == L'-' || json_str[0] == L'.'
-  ) {
-    if (json_str.find(L'.') == json_str.npos) {
-      *val = Json::Value((int64_t)std::stoll(json_str));
-    }
-    else {
-      *val = Json::Value(std::stod(json_str));
-    }
-  }
-  else if (json_str[0] == L'\"') {
-    size_t       st  = 1,    end = json_str.size();
-    bool         esc = false;
-    std::wstring res;
-
-    for (size_t i = 1; i < json_str.size(); ++i) {
-      if (!esc && json_str[i] == L'\"') {
-        if (end == json_str.size()) {
-          end = i;
-          res += std::wstring(json_str.begin() + st, json_str.begin() + end);
-        }
-        else {
-          end = json_str.size();
-          st = i + 1;
-        }
-      }
-
-      esc = json_str[i] == L'\\' && !esc;
-    }
+  Parser<Handler> parser(json_str.data(), json_str.data() + json_str.size());
+  if (parser.Parse(handler, log))
+    return ERR::SUCCESS;
 
-    val->m_type  = Json::String;
-    val->m_value = new std::wstring(format_in(res));
-  }
-  else if (json_str[0] == L'[' || json_str[0] == L'{') {
-    uint64_t square_br_c = 0;
-    uint64_t curly_br_c  = 0;
-    uint64_t last_comma  = 0;
-    bool     str         = false;
-    bool     esc         = false;
-
-    if (json_str[0] == L'[') {
-      val->m_type   = Json::List;
-      val->m_value  = new ListType;
-    }
-    else {
-      val->m_type   = Json::Struct;
-      val->m_value  = new StructType;
-    }
-
-    for (size_t i = 1; i < json_str.size(); ++i) {
-      if (!str) {
-        if (json_str[i] == L'[')
-          ++square_br_c;
-        else if (json_str[i] == L']')
-          --square_br_c;
-        else if (json_str[i] == L'{')
-          ++curly_br_c;
-        else if (json_str[i] == L'}')
-          --curly_br_c;
-        else if (square_br_c == 0 && curly_br_c == 0 && json_str[i] == L',') {
-          auto val_st  = json_str.begin() + last_comma + 1;
-          auto val_end = json_str.begin() + i;
-
-          last_comma = i;
-
-          while (
-            *val_st == L' ' || *val_st == L'\t' || *val_st == L'\r' || *val_st == L'\n'
-          ) {
-            ++val_st;
-          }
-          while (
-            *(val_end - 1) == L' ' || *(val_end - 1) == L'\t' || *(val_end - 1) == L'\r' || *(val_end - 1) == L'\n'
-          ) {
-            --val_end;
-          }
-
-          if (json_str[0] == L'[') {
-            Json::Value _val;
-            deserialize_value(
-              std::wstring(val_st, val_end),
-              &_val
-            );
-            ((ListType*)(val->m_value))->push_back(_val);
-          }
-          else {
-            Json::Property _prop(L"", Json::Value());
-            deserialize_property(
-              std::wstring(val_st, val_end),
-              &_prop
-            );
-            ((StructType*)(val->m_value))->push_back(_prop);
-          }
-        }
-      }
-
-      if (!esc && json_str[i] == L'\"')
-        str = !str;
-
-      if (str)
-        esc = json_str[i] == L'\\' && !esc;
-    }
-
-    auto val_st   = json_str.begin() + last_comma + 1;
-    auto val_end  = json_str.end() - 1;
-
-    while (
-      *val_st == L' ' || *val_st == L'\t' || *val_st == L'\r' || *val_st == L'\n'
-    ) {
-      ++val_st;
-    }
-    while (
-      *(val_end - 1) == L' ' || *(val_end - 1) == L'\t' || *(val_end - 1) == L'\r' || *(val_end - 1) == L'\n'
-    ) {
-      --val_end;
-    }
-
-    if (
-      val_end == json_str.begin() + last_comma + 1 &&
-      val_st  == json_str.end() - 1
-    ) {
-      return;
-    }
-
-    if (json_str[0] == L'[') {
-      Json::Value _val;
-      deserialize_value(
-        std::wstring(val_st, val_end),
-        &_val
-      );
-      ((ListType*)(val->m_value))->push_back(_val);
-    }
-    else {
-      Json::Property _prop(L"", Json::Value());
-      deserialize_property(
-        std::wstring(val_st, val_end),
-        &_prop
-      );
-      ((StructType*)(val->m_value))->push_back(_prop);
-    }
-  }
+  return parser.Aborted() ? ERR::ABORTED : ERR::BAD_JSON;
 }
@@ -3,8 +3,13 @@
 
 
 #include <string>
+#include <iosfwd>
+#include <cstdint>
 #include <vector>
+#include <memory>
 #include <filesystem>
+#include <string_view>
+#include <memory_resource>
 
 
 class Json
@@ -15,9 +20,27 @@ public:
   {
     SUCCESS = 0,
     BAD_PATH,
-    BAD_JSON
+    BAD_JSON,
+    ABORTED
   };
 
+  enum class ALLOC
+  {
+    HEAP = 0,
+    ARENA
+  };
+
+  enum class FORMAT
+  {
+    CBOR = 0,
+    MSGPACK
+  };
+
+  // Lists and structs nested deeper than this fail to parse or decode
+  // with ERR::BAD_JSON ("Nesting too deep"), so hostile input cannot
+  // exhaust the stack of the parser or of the recursive Value destructor.
+  static constexpr size_t MaxDepth = 1024;
+
   enum ValueType
   {
     Null,
@@ -31,9 +54,34 @@ public:
 
   class Property;
   class Value;
+  class Tape;
+  class Lazy;
+  class Snapshot;
+  class Handler;
+  class Writer;
+  class StreamParser;
+  class LinesReader;
+  class LinesWriter;
+  class KeyTable;
+  class Pointer;
+  class Projection;
+  class Reader;
+  class Emitter;
 
-  typedef std::vector<Property> StructType;
-  typedef std::vector<Value>    ListType;
+  template <typename Class, typename Member>
+  struct Field;
+  template <typename T>
+  struct Binding;
+  template <typename T, typename Enable = void>
+  struct Codec;
+
+  // Polymorphic-allocator containers, so that documents can live in an
+  // arena. They do not convert from std::vector<Value> or std::string;
+  // build them directly or go through the Value constructors taking
+  // iterators or a std::string.
+  typedef std::pmr::vector<Property> StructType;
+  typedef std::pmr::vector<Value>    ListType;
+  typedef std::pmr::string           StringType;
 
 
   static bool ValidateString(
@@ -48,6 +96,14 @@ public:
   static bool ValidateString(
     const std::wstring &json_string, std::string &log
   );
+  // Validation allocates nothing on valid input; the line and column of
+  // an error are only worked out when a log is requested.
+  static bool ValidateString(
+    const char *data, size_t size
+  );
+  static bool ValidateString(
+    const char *data, size_t size, std::string &log
+  );
   static Json::ERR ValidateFile(
     const std::filesystem::path &path
   );
@@ -55,59 +111,152 @@ public:
     const std::filesystem::path &path, std::string &log
   );
 
+  static Json::ERR ParseString(
+    const std::string &json_string, Handler &handler
+  );
+  static Json::ERR ParseString(
+    const std::string &json_string, Handler &handler, std::string &log
+  );
+  static Json::ERR ParseFile(
+    const std::filesystem::path &path, Handler &handler
+  );
+  static Json::ERR ParseFile(
+    const std::filesystem::path &path, Handler &handler, std::string &log
+  );
+  // Reports the events of a CBOR or MessagePack document; see Binary.
+  static Json::ERR ParseBinary(
+    std::string_view data, FORMAT format, Handler &handler
+  );
+
+  // Reads into and writes from bound C++ types without a Value; see
+  // bind.hpp.
+  template <typename T>
+  static Json::ERR Read(
+    std::string_view json_str, T &out
+  );
+  template <typename T>
+  static Json::ERR Read(
+    std::string_view json_str, T &out, std::string &log
+  );
+  template <typename T>
+  static Json::ERR ReadFile(
+    const std::filesystem::path &path, T &out
+  );
+  template <typename T>
+  static std::string Write(
+    const T &val
+  );
+  template <typename T>
+  static bool WriteFile(
+    const std::filesystem::path &path, const T &val
+  );
+
 
   Json();
+  // With ALLOC::ARENA every string and container of a parsed document is
+  // carved from an arena owned by this Json. Replaced documents keep their
+  // arena memory until Reset(). Moving a Value out of such a document
+  // keeps it in the arena, so it dangles after Reset() or once the Json
+  // is destroyed; copy it instead to keep it longer.
+  explicit Json(ALLOC alloc);
+  // Long property names of parsed documents are interned in keys, which
+  // may be shared with other Json objects and readers on any thread.
+  // Values moved out of the document keep pointing into the table.
+  explicit Json(std::shared_ptr<KeyTable> keys, ALLOC alloc = ALLOC::HEAP);
+  Json(const Json  &json);
+  // A moved-from Json holds an empty document on the heap.
+  Json(Json       &&json) noexcept;
   ~Json();
 
+  Json& operator=(const Json  &json);
+  Json& operator=(Json       &&json) noexcept;
+
 
   void Load          (const Value                 &val);
+  void Load          (Value                      &&val);
   ERR  LoadFromFile  (const std::filesystem::path &path);
   ERR  LoadFromString(const std::string           &json_string);
   ERR  LoadFromString(const std::wstring          &json_string);
+  // Parses a large top-level list or struct on several threads (0 for one
+  // per core) by splitting it between members. The result and any error
+  // are the same as with the single-threaded overloads. Documents in
+  // ALLOC::ARENA mode are always parsed on the calling thread.
+  ERR  LoadFromFile  (const std::filesystem::path &path,        size_t threads);
+  ERR  LoadFromString(const std::string           &json_string, size_t threads);
+  // Builds only the values on the projection's paths; see Projection.
+  ERR  LoadFromFile  (const std::filesystem::path &path,        const Projection &projection);
+  ERR  LoadFromString(const std::string           &json_string, const Projection &projection);
+  // CBOR or MessagePack documents; malformed input gives ERR::BAD_JSON.
+  ERR  LoadFromBinary    (std::string_view             data, FORMAT format);
+  ERR  LoadFromBinaryFile(const std::filesystem::path &path, FORMAT format);
 
   std::string   Serialize      ()                                  const;
   std::wstring  SerializeW     ()                                  const;
   bool          SerializeToFile(const std::filesystem::path &path) const;
 
-  Value&        GetData()       { return *m_data; }
-  const Value&  GetData() const { return *m_data; }
+  std::string   SerializeBinary      (FORMAT format)                                    const;
+  bool          SerializeBinary      (FORMAT format, std::ostream &stream)              const;
+  bool          SerializeBinaryToFile(const std::filesystem::path &path, FORMAT format) const;
+
+  Value&        GetData();
+  const Value&  GetData() const;
+
+  const std::shared_ptr<KeyTable>& GetKeyTable() const { return m_keys; }
+
+  void Reset();
 
 private:
 
-  Value *m_data;
+  template <typename Handler>
+  class Parser;
+  class NullHandler;
+  class DomBuilder;
+  class KeyIndex;
+  class Scanner;
+  class Number;
+  class MappedFile;
+  class ThreadPool;
+  class Arena;
+  class Binary;
+
+  Value                     *m_data;
+  Arena                     *m_arena;
+  std::shared_ptr<KeyTable>  m_keys;
+
+
+  std::pmr::memory_resource* resource() const;
+  ERR load(std::string_view json_str, size_t threads=1);
+  ERR load(std::string_view json_str, const Projection &projection);
+  ERR load(std::string_view input, FORMAT format);
 
   static std::string to_str(
     const std::wstring &wstr
   );
-  static bool read_file(
-    std::wstring &out, const std::filesystem::path &path
+  static std::wstring to_wstr(
+    std::string_view str
   );
-  static bool validate(
-    const std::wstring &json_str, std::string *log=nullptr
+  static size_t encode_utf8(
+    uint32_t code_point, char *out
   );
-  static bool validate_property(
-    const std::wstring &json_str, std::string *log, uint64_t ln, uint64_t col
+  static bool validate(
+    std::string_view json_str, std::string *log=nullptr
   );
-  static bool validate_value(
-    const std::wstring &json_str, std::string *log, uint64_t ln, uint64_t col
+  static bool split_container(
+    std::string_view json_str, ThreadPool &pool, char &type,
+    std::vector<const char*> &bounds
   );
-
-  static std::wstring format_in (std::wstring json_str);
-  static std::wstring format_out(std::wstring str);
-
-  static std::wstring serialize_property(
-    const Json::Property &prop
+  static bool load_parallel(
+    std::string_view json_str, size_t threads, KeyTable *keys, Value &out
   );
-  static std::wstring serialize_value(
-    const Json::Value &val
+  static Json::ERR parse(
+    std::string_view json_str, Handler &handler, std::string *log=nullptr
   );
-  static void deserialize_property(
-    const std::wstring &json_str, Json::Property *prop
+  static std::string make_log(
+    const char *msg, const char *first, const char *pos
   );
-  static void deserialize_value(
-    const std::wstring &json_str, Json::Value *val
+  static std::string make_log(
+    const char *msg, uint64_t ln, uint64_t col
   );
-
 };
 
 
@@ -0,0 +1,178 @@
+#include "key_index.hpp"
+#include "property.hpp"
+
+#include <cstring>
+#include <functional>
+
+
+static uint32_t slot_tag(size_t hash)
+{
+  return (uint32_t)(hash >> (sizeof(size_t) * 8 - 32));
+}
+
+// Names interned in the same KeyTable match by pointer.
+static bool same_name(std::string_view a, std::string_view b)
+{
+  return
+    a.size() == b.size() &&
+    (a.data() == b.data() || std::memcmp(a.data(), b.data(), a.size()) == 0);
+}
+
+
+Json::KeyIndex::KeyIndex() :
+  m_slots(std::pmr::new_delete_resource()), m_count(0), m_state(EMPTY)
+{}
+
+Json::KeyIndex::KeyIndex(const KeyIndex &index) :
+  KeyIndex()
+{
+  *this = index;
+}
+
+Json::KeyIndex& Json::KeyIndex::operator=(const KeyIndex &index)
+{
+  if (this == &index)
+    return *this;
+
+  // An index still being built elsewhere is left to be built again.
+  if (index.m_state.load(std::memory_order_acquire) != READY) {
+    Clear();
+    return *this;
+  }
+
+  m_slots = index.m_slots;
+  m_count = index.m_count;
+  m_state.store(READY, std::memory_order_relaxed);
+  return *this;
+}
+
+
+size_t Json::KeyIndex::Hash(std::string_view name)
+{
+  return std::hash<std::string_view>()(name);
+}
+
+
+size_t Json::KeyIndex::Find(
+  const StructType &props, std::string_view name
+) const
+{
+  if (!ready(props)) {
+    for (size_t i = 0; i < props.size(); ++i)
+      if (same_name(props[i].GetNameView(), name))
+        return i;
+
+    return npos;
+  }
+
+  return lookup(props, name, Hash(name));
+}
+
+size_t Json::KeyIndex::Find(
+  const StructType &props, std::string_view name, size_t hash
+) const
+{
+  if (!ready(props))
+    return Find(props, name);
+
+  return lookup(props, name, hash);
+}
+
+
+void Json::KeyIndex::Insert(const StructType &props, size_t i)
+{
+  if (m_state.load(std::memory_order_relaxed) != READY)
+    return;
+
+  if ((m_count + 1) * 2 > m_slots.size()) {
+    build(props);
+    return;
+  }
+
+  place(props, i, Hash(props[i].GetNameView()));
+}
+
+void Json::KeyIndex::Clear()
+{
+  m_slots.clear();
+  m_count = 0;
+  m_state.store(EMPTY, std::memory_order_relaxed);
+}
+
+
+// Builds the index on the first lookup that needs it. A thread that finds
+// another one building it scans linearly instead of waiting.
+bool Json::KeyIndex::ready(const StructType &props) const
+{
+  uint8_t state = m_state.load(std::memory_order_acquire);
+  if (state == READY)
+    return true;
+  if (state == BUILDING || props.size() < MinSize)
+    return false;
+
+  if (!m_state.compare_exchange_strong(state, BUILDING, std::memory_order_acquire))
+    return state == READY;
+
+  try {
+    build(props);
+  }
+  catch (...) {
+    m_slots.clear();
+    m_count = 0;
+    m_state.store(EMPTY, std::memory_order_release);
+    throw;
+  }
+
+  m_state.store(READY, std::memory_order_release);
+  return true;
+}
+
+void Json::KeyIndex::build(const StructType &props) const
+{
+  size_t cap = 32;
+  while (cap < props.size() * 2)
+    cap <<= 1;
+
+  m_slots.assign(cap, 0);
+  m_count = 0;
+  for (size_t i = 0; i < props.size(); ++i)
+    place(props, i, Hash(props[i].GetNameView()));
+}
+
+size_t Json::KeyIndex::lookup(
+  const StructType &props, std::string_view name, size_t hash
+) const
+{
+  size_t   mask = m_slots.size() - 1;
+  uint32_t tag  = slot_tag(hash);
+
+  for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+    uint64_t slot = m_slots[pos];
+    if (slot == 0)
+      return npos;
+
+    size_t i = (size_t)(uint32_t)slot - 1;
+    if ((uint32_t)(slot >> 32) == tag && same_name(props[i].GetNameView(), name))
+      return i;
+  }
+}
+
+
+void Json::KeyIndex::place(const StructType &props, size_t i, size_t hash) const
+{
+  size_t   mask = m_slots.size() - 1;
+  uint32_t tag  = slot_tag(hash);
+
+  for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+    uint64_t slot = m_slots[pos];
+    if (slot == 0) {
+      m_slots[pos] = ((uint64_t)tag << 32) | (uint64_t)(i + 1);
+      ++m_count;
+      return;
+    }
+
+    size_t j = (size_t)(uint32_t)slot - 1;
+    if ((uint32_t)(slot >> 32) == tag && same_name(props[j].GetNameView(), props[i].GetNameView()))
+      return;
+  }
+}
@@ -0,0 +1,65 @@
+#ifndef SOURCE_KEY_INDEX_HPP
+#define SOURCE_KEY_INDEX_HPP
+
+
+#include "json.hpp"
+
+#include <atomic>
+#include <string_view>
+
+
+// Open-addressing hash index over the property names of a struct. It is
+// built by the first lookup once the struct has MinSize properties, so
+// parsing and iterating never pay for it; smaller structs are scanned
+// linearly. Duplicate names resolve to the first property, the same as a
+// linear scan.
+//
+// Lookups on a const struct may run on several threads: one of them
+// builds the index while the others scan. The slots are always taken
+// from the heap, so a lookup never allocates from a document's arena.
+class Json::KeyIndex
+{
+public:
+
+  static constexpr size_t MinSize = 16;
+  static constexpr size_t npos    = (size_t)-1;
+
+  KeyIndex();
+  KeyIndex(const KeyIndex &index);
+
+  KeyIndex& operator=(const KeyIndex &index);
+
+  static size_t Hash(std::string_view name);
+
+  size_t Find(const StructType &props, std::string_view name) const;
+  size_t Find(const StructType &props, std::string_view name, size_t hash) const;
+
+  // Keeps a built index in step with a property appended at i.
+  void Insert(const StructType &props, size_t i);
+  // Drops the index after properties were removed or replaced; the next
+  // lookup builds it again.
+  void Clear ();
+
+private:
+
+  enum State : uint8_t
+  {
+    EMPTY,
+    BUILDING,
+    READY
+  };
+
+  mutable std::pmr::vector<uint64_t> m_slots;
+  mutable size_t                     m_count;
+  mutable std::atomic<uint8_t>       m_state;
+
+
+  bool   ready (const StructType &props) const;
+  void   build (const StructType &props) const;
+  size_t lookup(const StructType &props, std::string_view name, size_t hash) const;
+  void   place (const StructType &props, size_t i, size_t hash) const;
+
+};
+
+
+#endif // !SOURCE_KEY_INDEX_HPP
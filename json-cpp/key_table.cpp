@@ -0,0 +1,72 @@
+#include "key_table.hpp"
+#include "key_index.hpp"
+
+#include <cstring>
+#include <mutex>
+
+
+static constexpr size_t BlockSize = 16 * 1024;
+
+
+Json::KeyTable::KeyTable() :
+  m_used(BlockSize)
+{}
+
+Json::KeyTable::~KeyTable()
+{}
+
+
+std::string_view Json::KeyTable::Intern(std::string_view key)
+{
+  {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    auto it = m_keys.find(key);
+    if (it != m_keys.end())
+      return *it;
+  }
+
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+  auto it = m_keys.find(key);
+  if (it != m_keys.end())
+    return *it;
+
+  char *copy;
+  if (key.size() > BlockSize / 4) {
+    // Long keys get a block of their own, kept before the one being filled.
+    auto pos = m_blocks.empty() ? m_blocks.end() : m_blocks.end() - 1;
+    copy     = m_blocks.emplace(pos, new char[key.size()])->get();
+  }
+  else {
+    if (BlockSize - m_used < key.size()) {
+      m_blocks.emplace_back(new char[BlockSize]);
+      m_used = 0;
+    }
+    copy    = m_blocks.back().get() + m_used;
+    m_used += key.size();
+  }
+
+  std::memcpy(copy, key.data(), key.size());
+  return *m_keys.emplace(copy, key.size()).first;
+}
+
+std::string_view Json::KeyTable::Find(std::string_view key) const
+{
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+  auto it = m_keys.find(key);
+  return it == m_keys.end() ? std::string_view() : *it;
+}
+
+size_t Json::KeyTable::Size() const
+{
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+  return m_keys.size();
+}
+
+
+size_t Json::KeyTable::Hash::operator()(std::string_view key) const
+{
+  return KeyIndex::Hash(key);
+}
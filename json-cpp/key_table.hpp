@@ -0,0 +1,53 @@
+#ifndef SOURCE_KEY_TABLE_HPP
+#define SOURCE_KEY_TABLE_HPP
+
+
+#include "json.hpp"
+
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_set>
+
+
+// Thread-safe set of immutable property names. Documents parsed with a
+// table store their longer property names as pointers into it, so records
+// with the same keys share one copy of each. Interned names stay valid
+// for the lifetime of the table; it only grows.
+//
+//   auto keys = std::make_shared<Json::KeyTable>();
+//   Json a(keys), b(keys);
+class Json::KeyTable
+{
+public:
+
+  KeyTable();
+  ~KeyTable();
+
+  KeyTable(const KeyTable &table)            = delete;
+  KeyTable& operator=(const KeyTable &table) = delete;
+
+  // The table's copy of key, added on first use. Looking properties up by
+  // an interned name compares pointers before contents.
+  std::string_view Intern(std::string_view key);
+  // Null data when key has not been interned.
+  std::string_view Find  (std::string_view key) const;
+
+  size_t Size() const;
+
+private:
+
+  struct Hash
+  {
+    size_t operator()(std::string_view key) const;
+  };
+
+  mutable std::shared_mutex                  m_mutex;
+  std::unordered_set<std::string_view, Hash> m_keys;
+  std::vector<std::unique_ptr<char[]>>       m_blocks;
+  size_t                                     m_used;
+
+};
+
+
+#endif // !SOURCE_KEY_TABLE_HPP
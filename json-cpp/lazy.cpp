@@ -0,0 +1,425 @@
+#include "lazy.hpp"
+#include "parser.hpp"
+#include "dom_builder.hpp"
+#include "property.hpp"
+
+#include <cstring>
+
+
+static constexpr size_t NoIndex = (size_t)-1;
+
+
+// Validating handler that only records the extent of every container.
+class Json::Lazy::Indexer
+{
+public:
+
+  static constexpr bool Decode = false;
+  static constexpr bool Filter = false;
+
+  Indexer(Lazy *doc, const Parser<Indexer> *parser) :
+    m_doc(doc), m_parser(parser)
+  {}
+
+  bool Null  ()                 { return true; }
+  bool Bool  (bool)             { return true; }
+  bool Int   (int64_t)          { return true; }
+  bool Float (double)           { return true; }
+  bool String(std::string_view) { return true; }
+  bool Key   (std::string_view) { return true; }
+
+  bool StartList  ()             { return open();       }
+  bool EndList    (size_t count) { return close(count); }
+  bool StartStruct()             { return open();       }
+  bool EndStruct  (size_t count) { return close(count); }
+
+private:
+
+  Lazy                  *m_doc;
+  const Parser<Indexer> *m_parser;
+  std::vector<size_t>    m_stack;
+
+
+  bool open()
+  {
+    m_stack.push_back(m_doc->m_index.size());
+    m_doc->m_index.push_back({ 0, 0, 0 });
+    return true;
+  }
+
+  bool close(size_t count)
+  {
+    Container &cont = m_doc->m_index[m_stack.back()];
+    m_stack.pop_back();
+
+    cont.close = (size_t)(m_parser->Position() - 1 - m_doc->m_input.data());
+    cont.next  = m_doc->m_index.size();
+    cont.count = count;
+    return true;
+  }
+
+};
+
+
+// Picks the decoded text of a single string token.
+class Json::Lazy::Decoder
+{
+public:
+
+  static constexpr bool Decode = true;
+  static constexpr bool Filter = false;
+
+  explicit Decoder(std::string *out) : m_out(out) {}
+
+  bool Null  ()                     { return true; }
+  bool Bool  (bool)                 { return true; }
+  bool Int   (int64_t)              { return true; }
+  bool Float (double)               { return true; }
+  bool String(std::string_view str) { m_out->assign(str); return true; }
+  bool Key   (std::string_view)     { return true; }
+
+  bool StartList  ()       { return true; }
+  bool EndList    (size_t) { return true; }
+  bool StartStruct()       { return true; }
+  bool EndStruct  (size_t) { return true; }
+
+private:
+
+  std::string *m_out;
+
+};
+
+
+Json::Lazy::Lazy()
+{}
+
+
+Json::ERR Json::Lazy::LoadFromFile(const std::filesystem::path &path)
+{
+  if (!m_file.Open(path))
+    return ERR::BAD_PATH;
+
+  return load(m_file.GetData(), nullptr);
+}
+
+Json::ERR Json::Lazy::LoadFromString(std::string_view json_string)
+{
+  return load(json_string, nullptr);
+}
+
+Json::ERR Json::Lazy::LoadFromString(std::string_view json_string, std::string &log)
+{
+  return load(json_string, &log);
+}
+
+
+Json::Lazy::View Json::Lazy::GetData() const
+{
+  if (m_input.empty())
+    throw Value::NotFound;
+
+  const char *pos = Scanner::SkipWhitespace(
+    m_input.data(), m_input.data() + m_input.size()
+  );
+  return View(this, pos, nullptr, *pos == '[' || *pos == '{' ? 0 : NoIndex);
+}
+
+
+Json::ERR Json::Lazy::load(std::string_view json_string, std::string *log)
+{
+  if (json_string.data() != m_file.GetData().data())
+    m_file.Close();
+
+  m_index.clear();
+  m_input = json_string;
+
+  Parser<Indexer> parser(
+    json_string.data(), json_string.data() + json_string.size()
+  );
+  Indexer indexer(this, &parser);
+  if (!parser.Parse(indexer, log)) {
+    m_index.clear();
+    m_input = std::string_view();
+    return ERR::BAD_JSON;
+  }
+
+  return ERR::SUCCESS;
+}
+
+
+// pos is at the opening quote of a valid string; returns one past the
+// closing quote.
+const char* Json::Lazy::skip_string(const char *pos, const char *last, bool *escaped)
+{
+  for (++pos;; pos += 2) {
+    pos = Scanner::FindQuote(pos, last);
+    if (*pos == '\"')
+      return pos + 1;
+    if (escaped)
+      *escaped = true;
+  }
+}
+
+const char* Json::Lazy::skip_scalar(const char *pos, const char *last)
+{
+  if (*pos == '\"')
+    return skip_string(pos, last);
+
+  while (
+    pos != last && *pos != ',' && *pos != ']' && *pos != '}' &&
+    *pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '\n'
+  ) {
+    ++pos;
+  }
+  return pos;
+}
+
+// [first, last) is a whole string token, quotes included.
+std::string Json::Lazy::decode(const char *first, const char *last)
+{
+  if (!std::memchr(first + 1, '\\', last - first - 2))
+    return std::string(first + 1, last - 1);
+
+  std::string out;
+  Decoder     decoder(&out);
+  Parser<Decoder>(first, last).Parse(decoder);
+  return out;
+}
+
+
+Json::ValueType Json::Lazy::View::GetType() const
+{
+  switch (*m_pos)
+  {
+  case 'n':  return Null;
+  case 't':
+  case 'f':  return Bool;
+  case '\"': return String;
+  case '[':  return List;
+  case '{':  return Struct;
+  default:   return is_int() ? Int : Float;
+  }
+}
+
+
+bool Json::Lazy::View::GetBool() const
+{
+  if (*m_pos != 't' && *m_pos != 'f')
+    throw Value::WrongType;
+
+  return *m_pos == 't';
+}
+
+int64_t Json::Lazy::View::GetInt() const
+{
+  int64_t val;
+  if (
+    GetType() != Int ||
+    !Number::ParseInt(m_pos, value_end(), val)
+  ) {
+    throw Value::WrongType;
+  }
+
+  return val;
+}
+
+double Json::Lazy::View::GetFloat() const
+{
+  if (GetType() != Float)
+    throw Value::WrongType;
+
+  return Number::ParseFloat(m_pos, value_end());
+}
+
+std::string Json::Lazy::View::GetString() const
+{
+  if (*m_pos != '\"')
+    throw Value::WrongType;
+
+  return decode(m_pos, value_end());
+}
+
+std::wstring Json::Lazy::View::GetStringW() const
+{
+  return Json::to_wstr(GetString());
+}
+
+
+std::string_view Json::Lazy::View::GetRaw() const
+{
+  return std::string_view(m_pos, value_end() - m_pos);
+}
+
+std::string Json::Lazy::View::GetName() const
+{
+  if (!m_key)
+    return std::string();
+
+  return decode(m_key, skip_string(m_key, last()));
+}
+
+
+size_t Json::Lazy::View::Size() const
+{
+  if (m_index == NoIndex)
+    throw Value::WrongType;
+
+  return m_doc->m_index[m_index].count;
+}
+
+bool Json::Lazy::View::Contains(std::string_view prop_name) const
+{
+  if (*m_pos != '{')
+    throw Value::NotStruct;
+
+  for (Iterator it = begin(); it != end(); ++it)
+    if (it.match(prop_name))
+      return true;
+
+  return false;
+}
+
+bool Json::Lazy::View::Contains(const std::wstring &prop_name) const
+{
+  return Contains(Json::to_str(prop_name));
+}
+
+
+Json::Lazy::View Json::Lazy::View::operator[](std::string_view prop_name) const
+{
+  if (*m_pos != '{')
+    throw Value::NotStruct;
+
+  for (Iterator it = begin(); it != end(); ++it)
+    if (it.match(prop_name))
+      return *it;
+
+  throw Value::NotFound;
+}
+
+Json::Lazy::View Json::Lazy::View::operator[](const std::wstring &prop_name) const
+{
+  return (*this)[Json::to_str(prop_name)];
+}
+
+Json::Lazy::View Json::Lazy::View::operator[](size_t i) const
+{
+  if (*m_pos != '[')
+    throw Value::NotList;
+  if (i >= m_doc->m_index[m_index].count)
+    throw Value::NotFound;
+
+  Iterator it = begin();
+  for (; i != 0; --i)
+    ++it;
+  return *it;
+}
+
+
+Json::Lazy::Iterator Json::Lazy::View::begin() const
+{
+  if (m_index == NoIndex)
+    throw Value::WrongType;
+
+  Iterator it(View(m_doc, nullptr, nullptr, NoIndex), m_index + 1, *m_pos == '{');
+  it.enter(m_pos + 1);
+  return it;
+}
+
+Json::Lazy::Iterator Json::Lazy::View::end() const
+{
+  if (m_index == NoIndex)
+    throw Value::WrongType;
+
+  return Iterator(View(m_doc, nullptr, nullptr, NoIndex), 0, *m_pos == '{');
+}
+
+
+Json::Value Json::Lazy::View::ToValue() const
+{
+  Value      val;
+  DomBuilder builder(&val);
+  Parser<DomBuilder>(m_pos, value_end()).Parse(builder);
+  return val;
+}
+
+
+const char* Json::Lazy::View::value_end() const
+{
+  if (m_index != NoIndex)
+    return m_doc->m_input.data() + m_doc->m_index[m_index].close + 1;
+
+  return skip_scalar(m_pos, last());
+}
+
+bool Json::Lazy::View::is_int() const
+{
+  const char *end = value_end();
+  for (const char *pos = m_pos; pos != end; ++pos)
+    if (*pos == '.' || *pos == 'e' || *pos == 'E')
+      return false;
+
+  int64_t val;
+  return Number::ParseInt(m_pos, end, val);
+}
+
+
+Json::Lazy::Iterator& Json::Lazy::Iterator::operator++()
+{
+  const char *pos = m_view.m_pos;
+
+  if (m_view.m_index != NoIndex) {
+    const Container &cont = m_view.m_doc->m_index[m_view.m_index];
+    pos    = m_view.m_doc->m_input.data() + cont.close + 1;
+    m_next = cont.next;
+  }
+  else {
+    pos = skip_scalar(pos, m_view.last());
+  }
+
+  pos = Scanner::SkipWhitespace(pos, m_view.last());
+  if (*pos == ',')
+    ++pos;
+  enter(pos);
+  return *this;
+}
+
+// pos is where the next element or member may start, or at the closing
+// bracket of the container.
+void Json::Lazy::Iterator::enter(const char *pos)
+{
+  const char *last = m_view.last();
+
+  pos          = Scanner::SkipWhitespace(pos, last);
+  m_view.m_key = nullptr;
+
+  if (*pos == ']' || *pos == '}') {
+    m_view.m_pos   = nullptr;
+    m_view.m_index = NoIndex;
+    return;
+  }
+
+  if (m_struct) {
+    m_key_escaped = false;
+    m_key_end     = skip_string(pos, last, &m_key_escaped);
+    m_view.m_key  = pos;
+
+    pos = Scanner::SkipWhitespace(m_key_end, last);
+    pos = Scanner::SkipWhitespace(pos + 1, last);
+  }
+
+  m_view.m_pos   = pos;
+  m_view.m_index = *pos == '[' || *pos == '{' ? m_next : NoIndex;
+}
+
+// Keys without escapes are compared in place.
+bool Json::Lazy::Iterator::match(std::string_view name) const
+{
+  const char *key = m_view.m_key + 1;
+  size_t      len = (size_t)(m_key_end - 1 - key);
+
+  if (!m_key_escaped)
+    return len == name.size() && std::memcmp(key, name.data(), len) == 0;
+
+  return decode(m_view.m_key, m_key_end) == name;
+}
@@ -0,0 +1,155 @@
+#ifndef SOURCE_LAZY_HPP
+#define SOURCE_LAZY_HPP
+
+
+#include "json.hpp"
+#include "value.hpp"
+#include "mapped_file.hpp"
+
+#include <string_view>
+
+
+// On-demand document. Loading validates the input and records, for every
+// list and struct, where it closes, how many members it has and where the
+// next container after it starts. Nothing is decoded or allocated per
+// value: a View points into the input and converts a number or string
+// only when asked, walking a container's members and jumping over the
+// nested containers it does not need:
+//
+//   Json::Lazy doc;
+//   doc.LoadFromString(request);
+//   int64_t id = doc.GetData()["user"]["id"].GetInt();
+//
+// The input must outlive the document when loaded with LoadFromString.
+class Json::Lazy
+{
+public:
+
+  class View;
+  class Iterator;
+
+  Lazy();
+
+  Lazy(const Lazy &lazy)            = delete;
+  Lazy& operator=(const Lazy &lazy) = delete;
+
+  ERR LoadFromFile  (const std::filesystem::path &path);
+  ERR LoadFromString(std::string_view             json_string);
+  ERR LoadFromString(std::string_view             json_string, std::string &log);
+
+  View GetData() const;
+
+private:
+
+  class Indexer;
+  class Decoder;
+
+  struct Container
+  {
+    size_t close;
+    size_t next;
+    size_t count;
+  };
+
+  std::vector<Container> m_index;
+  MappedFile             m_file;
+  std::string_view       m_input;
+
+
+  ERR load(std::string_view json_string, std::string *log);
+
+  static const char* skip_string(const char *pos, const char *last, bool *escaped=nullptr);
+  static const char* skip_scalar(const char *pos, const char *last);
+  static std::string decode     (const char *first, const char *last);
+
+};
+
+
+class Json::Lazy::View
+{
+public:
+
+  ValueType GetType() const;
+
+  bool         GetBool   () const;
+  int64_t      GetInt    () const;
+  double       GetFloat  () const;
+  std::string  GetString () const;
+  std::wstring GetStringW() const;
+
+  // The value's JSON text as it appears in the input.
+  std::string_view GetRaw () const;
+  // Name of the struct member the view was reached through, or "".
+  std::string      GetName() const;
+
+  size_t Size    ()                              const;
+  bool   Contains(std::string_view    prop_name) const;
+  bool   Contains(const std::wstring &prop_name) const;
+
+  View operator[](std::string_view    prop_name) const;
+  View operator[](const std::wstring &prop_name) const;
+  View operator[](size_t              i)         const;
+
+  // Elements of a list or member values of a struct, in input order.
+  Iterator begin() const;
+  Iterator end  () const;
+
+  Value ToValue() const;
+
+private:
+
+  const Lazy *m_doc;
+  const char *m_pos;
+  const char *m_key;
+  size_t      m_index;
+
+
+  View(const Lazy *doc, const char *pos, const char *key, size_t index) :
+    m_doc(doc), m_pos(pos), m_key(key), m_index(index)
+  {}
+
+  const char* last     () const { return m_doc->m_input.data() + m_doc->m_input.size(); }
+  const char* value_end() const;
+  bool        is_int   () const;
+
+  friend class Json::Lazy;
+  friend class Json::Lazy::Iterator;
+
+};
+
+
+class Json::Lazy::Iterator
+{
+public:
+
+  View operator*() const { return m_view; }
+
+  Iterator& operator++();
+
+  bool operator==(const Iterator &it) const { return m_view.m_pos == it.m_view.m_pos; }
+  bool operator!=(const Iterator &it) const { return m_view.m_pos != it.m_view.m_pos; }
+
+private:
+
+  View        m_view;
+  // Index entry of the next container at or after the current value.
+  size_t      m_next;
+  bool        m_struct;
+  const char *m_key_end;
+  bool        m_key_escaped;
+
+
+  Iterator(const View &view, size_t next, bool is_struct) :
+    m_view(view), m_next(next), m_struct(is_struct),
+    m_key_end(nullptr), m_key_escaped(false)
+  {}
+
+  void enter(const char *pos);
+  bool match(std::string_view name) const;
+
+  friend class Json::Lazy::View;
+
+};
+
+
+#endif // !SOURCE_LAZY_HPP
@@ -0,0 +1,247 @@
+#include "lines.hpp"
+#include "parser.hpp"
+#include "dom_builder.hpp"
+#include "thread_pool.hpp"
+#include "key_table.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+static constexpr size_t BlockSize       = 1024 * 1024;
+static constexpr size_t LinesPerThread  = 256;
+static constexpr size_t LinesPerTask    = 32;
+static constexpr size_t WriteBufferSize = 1024 * 1024;
+
+
+Json::LinesReader::LinesReader(size_t threads, std::shared_ptr<KeyTable> keys) :
+  m_pool(new ThreadPool(threads)), m_keys(std::move(keys)),
+  m_stream(nullptr), m_next_line(1),
+  m_size(0), m_pos(0), m_line(0), m_err(ERR::SUCCESS)
+{
+  m_batch.resize(m_pool->Size() == 1 ? 1 : m_pool->Size() * LinesPerThread);
+}
+
+Json::LinesReader::~LinesReader()
+{}
+
+
+Json::ERR Json::LinesReader::Open(const std::filesystem::path &path)
+{
+  reset();
+  if (!m_file.Open(path))
+    return ERR::BAD_PATH;
+
+  m_data = m_file.GetData();
+  return ERR::SUCCESS;
+}
+
+void Json::LinesReader::OpenStream(std::istream &stream)
+{
+  reset();
+  m_stream = &stream;
+}
+
+void Json::LinesReader::OpenString(std::string_view data)
+{
+  reset();
+  m_data = data;
+}
+
+
+bool Json::LinesReader::Next(Value &val)
+{
+  if (m_pos == m_size && !fill())
+    return false;
+
+  Record &rec = m_batch[m_pos++];
+  if (!rec.ok) {
+    m_err  = ERR::BAD_JSON;
+    m_log  = "Line " + std::to_string(rec.line) + ": " + rec.log;
+    m_line = rec.line;
+    m_size = m_pos = 0;
+    m_data = std::string_view();
+    m_stream = nullptr;
+    return false;
+  }
+
+  val    = std::move(rec.val);
+  m_line = rec.line;
+  return true;
+}
+
+
+void Json::LinesReader::reset()
+{
+  m_file.Close();
+  m_stream    = nullptr;
+  m_data      = std::string_view();
+  m_next_line = 1;
+  m_size      = 0;
+  m_pos       = 0;
+  m_line      = 0;
+  m_err       = ERR::SUCCESS;
+  m_block.clear();
+  m_log.clear();
+}
+
+bool Json::LinesReader::fill()
+{
+  m_size = m_pos = 0;
+
+  std::string_view line;
+  while (m_size != m_batch.size() && read_line(line))
+    m_batch[m_size++].text = line;
+
+  if (m_size == 0)
+    return false;
+
+  m_pool->Run(
+    (m_size + LinesPerTask - 1) / LinesPerTask,
+    [this](size_t task)
+    {
+      size_t last = std::min((task + 1) * LinesPerTask, m_size);
+      for (size_t i = task * LinesPerTask; i != last; ++i)
+        parse(m_batch[i]);
+    }
+  );
+  return true;
+}
+
+// Next non-blank line. In stream mode the block is only refilled while no
+// line of the current batch points into it.
+bool Json::LinesReader::read_line(std::string_view &line)
+{
+  for (;;) {
+    size_t end = m_data.find('\n');
+
+    if (end == std::string_view::npos && m_stream) {
+      if (m_size != 0)
+        return false;
+      if (refill())
+        continue;
+    }
+
+    if (m_data.empty())
+      return false;
+
+    if (end == std::string_view::npos)
+      end = m_data.size();
+
+    line   = m_data.substr(0, end);
+    m_data = m_data.substr(std::min(end + 1, m_data.size()));
+
+    m_batch[m_size].line = m_next_line++;
+
+    if (!line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+    if (
+      line.find_first_not_of(" \t\r") != std::string_view::npos
+    ) {
+      return true;
+    }
+  }
+}
+
+bool Json::LinesReader::refill()
+{
+  size_t keep = m_data.size();
+  if (keep != 0)
+    std::memmove(m_block.data(), m_data.data(), keep);
+  m_block.resize(std::max(keep + BlockSize, m_block.size()));
+
+  m_stream->read(m_block.data() + keep, m_block.size() - keep);
+  size_t got = (size_t)m_stream->gcount();
+
+  m_block.resize(keep + got);
+  m_data = m_block;
+
+  if (got == 0) {
+    m_stream = nullptr;
+    return false;
+  }
+  return true;
+}
+
+void Json::LinesReader::parse(Record &rec)
+{
+  rec.val = Value();
+  rec.log.clear();
+
+  DomBuilder builder(&rec.val, std::pmr::get_default_resource(), m_keys.get());
+  rec.ok = Parser<DomBuilder>(
+    rec.text.data(), rec.text.data() + rec.text.size()
+  ).Parse(builder, &rec.log);
+}
+
+
+Json::LinesWriter::LinesWriter(std::ostream &stream, size_t threads) :
+  m_pool(new ThreadPool(threads)), m_stream(&stream), m_writer(m_buffer)
+{
+  m_buffer.reserve(WriteBufferSize);
+  m_parts.resize(m_pool->Size());
+}
+
+Json::LinesWriter::~LinesWriter()
+{
+  Flush();
+}
+
+
+bool Json::LinesWriter::Write(const Value &val)
+{
+  m_writer.Write(val);
+  m_buffer.push_back('\n');
+  if (m_buffer.size() >= WriteBufferSize)
+    return Flush();
+
+  return !m_stream->fail();
+}
+
+bool Json::LinesWriter::Write(const ListType &values)
+{
+  const size_t parts = m_parts.size();
+
+  if (parts == 1 || values.size() < parts * LinesPerThread) {
+    for (const Value &val : values)
+      if (!Write(val))
+        return false;
+    return true;
+  }
+
+  // Large lists go out in rounds: every thread serializes one slice of
+  // records into its own buffer, then the slices are written in order.
+  size_t step = std::max(values.size() / (parts * 8), (size_t)1);
+  for (size_t first = 0; first < values.size(); first += step * parts) {
+    m_pool->Run(parts, [&](size_t part)
+    {
+      std::string &out  = m_parts[part];
+      size_t       st   = first + part * step;
+      size_t       last = std::min(st + step, values.size());
+
+      out.clear();
+      Writer writer(out);
+      for (size_t i = st; i < last; ++i) {
+        writer.Write(values[i]);
+        out.push_back('\n');
+      }
+    });
+
+    if (!Flush())
+      return false;
+    for (const std::string &out : m_parts)
+      m_stream->write(out.data(), out.size());
+    if (m_stream->fail())
+      return false;
+  }
+
+  return true;
+}
+
+bool Json::LinesWriter::Flush()
+{
+  m_stream->write(m_buffer.data(), m_buffer.size());
+  m_buffer.clear();
+  return !m_stream->fail();
+}
+
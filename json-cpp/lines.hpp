@@ -0,0 +1,119 @@
+#ifndef SOURCE_LINES_HPP
+#define SOURCE_LINES_HPP
+
+
+#include "json.hpp"
+#include "value.hpp"
+#include "property.hpp"
+#include "mapped_file.hpp"
+#include "writer.hpp"
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string_view>
+
+
+// Reads newline-delimited JSON (JSON Lines / NDJSON) one record per line.
+// Blank lines are skipped. With more than one thread, lines are parsed in
+// batches across a pool and still returned in input order:
+//
+//   Json::LinesReader reader(0);
+//   reader.Open("events.ndjson");
+//   for (Json::Value val; reader.Next(val);)
+//     handle(val);
+//   if (reader.GetError() != Json::ERR::SUCCESS)
+//     fail(reader.GetLog());
+//
+// Reading stops at the first malformed line.
+class Json::LinesReader
+{
+public:
+
+  // 0 uses one thread per hardware core. With a key table, long property
+  // names of the records are interned in it.
+  explicit LinesReader(size_t threads = 1, std::shared_ptr<KeyTable> keys = nullptr);
+  ~LinesReader();
+
+  LinesReader(const LinesReader &reader)            = delete;
+  LinesReader& operator=(const LinesReader &reader) = delete;
+
+  ERR  Open      (const std::filesystem::path &path);
+  void OpenStream(std::istream                &stream);
+  // The data must outlive the reader.
+  void OpenString(std::string_view             data);
+
+  bool Next(Value &val);
+
+  // Line number of the record last returned by Next().
+  size_t             GetLine () const { return m_line; }
+  ERR                GetError() const { return m_err;  }
+  const std::string& GetLog  () const { return m_log;  }
+
+private:
+
+  struct Record
+  {
+    std::string_view text;
+    size_t           line;
+    Value            val;
+    bool             ok;
+    std::string      log;
+  };
+
+  std::unique_ptr<ThreadPool>  m_pool;
+  std::shared_ptr<KeyTable>    m_keys;
+  MappedFile                   m_file;
+  std::istream                *m_stream;
+  std::string                  m_block;
+  std::string_view             m_data;
+  size_t                       m_next_line;
+
+  std::vector<Record> m_batch;
+  size_t              m_size;
+  size_t              m_pos;
+
+  size_t      m_line;
+  ERR         m_err;
+  std::string m_log;
+
+
+  void reset();
+  bool fill ();
+  bool read_line(std::string_view &line);
+  bool refill   ();
+  void parse    (Record &rec);
+
+};
+
+
+// Writes one serialized Value per line into a stream, collecting output
+// in a large buffer between writes to the stream. Flush() or destruction
+// pushes out what is left. With more than one thread, Write(const
+// ListType&) serializes slices of the list in parallel.
+class Json::LinesWriter
+{
+public:
+
+  explicit LinesWriter(std::ostream &stream, size_t threads = 1);
+  ~LinesWriter();
+
+  LinesWriter(const LinesWriter &writer)            = delete;
+  LinesWriter& operator=(const LinesWriter &writer) = delete;
+
+  bool Write(const Value    &val);
+  bool Write(const ListType &values);
+  bool Flush();
+
+private:
+
+  std::unique_ptr<ThreadPool>  m_pool;
+  std::ostream                *m_stream;
+  std::string                  m_buffer;
+  Writer                       m_writer;
+  std::vector<std::string>     m_parts;
+
+};
+
+
+#endif // !SOURCE_LINES_HPP
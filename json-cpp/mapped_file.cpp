@@ -0,0 +1,144 @@
+#include "mapped_file.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define JSON_MAPPED_FILE_POSIX
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+
+static constexpr size_t ReadChunkSize = 64 * 1024;
+
+
+Json::MappedFile::MappedFile() :
+  m_data(nullptr), m_size(0), m_mapped(false)
+{}
+
+Json::MappedFile::~MappedFile()
+{
+  Close();
+}
+
+
+#ifdef JSON_MAPPED_FILE_POSIX
+
+bool Json::MappedFile::Open(const std::filesystem::path &path)
+{
+  int fd;
+  do
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  while (fd == -1 && errno == EINTR);
+
+  if (fd == -1)
+    return false;
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+
+  if (S_ISREG(st.st_mode) && st.st_size > 0) {
+    void *addr = ::mmap(
+      nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0
+    );
+    if (addr != MAP_FAILED) {
+      ::madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL);
+      ::close(fd);
+
+      Close();
+      m_data   = (const char*)addr;
+      m_size   = (size_t)st.st_size;
+      m_mapped = true;
+      return true;
+    }
+  }
+
+  // Not mappable: a pipe, a device, a file in /proc reporting size 0 or a
+  // filesystem refusing mmap.
+  std::string buffer(
+    S_ISREG(st.st_mode) && st.st_size > 0 ? (size_t)st.st_size : ReadChunkSize,
+    '\0'
+  );
+  size_t size = 0;
+
+  for (;;) {
+    if (size == buffer.size())
+      buffer.resize(buffer.size() + ReadChunkSize);
+
+    ssize_t got = ::read(fd, buffer.data() + size, buffer.size() - size);
+    if (got == 0)
+      break;
+    if (got < 0) {
+      if (errno == EINTR)
+        continue;
+      ::close(fd);
+      return false;
+    }
+    size += (size_t)got;
+  }
+
+  ::close(fd);
+  buffer.resize(size);
+
+  Close();
+  m_buffer.swap(buffer);
+  m_data = m_buffer.data();
+  m_size = m_buffer.size();
+  return true;
+}
+
+void Json::MappedFile::Close()
+{
+  if (m_mapped)
+    ::munmap((void*)m_data, m_size);
+
+  m_buffer.clear();
+  m_buffer.shrink_to_fit();
+  m_data   = nullptr;
+  m_size   = 0;
+  m_mapped = false;
+}
+
+#else
+
+bool Json::MappedFile::Open(const std::filesystem::path &path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return false;
+
+  std::string     buffer;
+  std::error_code ec;
+  auto size = std::filesystem::file_size(path, ec);
+  if (!ec)
+    buffer.reserve(size);
+
+  buffer.assign(
+    std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()
+  );
+  if (file.bad())
+    return false;
+
+  Close();
+  m_buffer.swap(buffer);
+  m_data = m_buffer.data();
+  m_size = m_buffer.size();
+  return true;
+}
+
+void Json::MappedFile::Close()
+{
+  m_buffer.clear();
+  m_buffer.shrink_to_fit();
+  m_data = nullptr;
+  m_size = 0;
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef SOURCE_MAPPED_FILE_HPP
+#define SOURCE_MAPPED_FILE_HPP
+
+
+#include "json.hpp"
+
+
+// Read-only view of a whole file. Regular files are mapped into memory;
+// pipes, character devices and platforms without mmap fall back to reading
+// the file into an owned buffer. A failed Open() keeps the previous
+// contents.
+class Json::MappedFile
+{
+public:
+
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile &file)            = delete;
+  MappedFile& operator=(const MappedFile &file) = delete;
+
+  bool Open (const std::filesystem::path &path);
+  void Close();
+
+  std::string_view GetData() const { return std::string_view(m_data, m_size); }
+
+private:
+
+  const char  *m_data;
+  size_t       m_size;
+  bool         m_mapped;
+  std::string  m_buffer;
+
+};
+
+
+#endif // !SOURCE_MAPPED_FILE_HPP
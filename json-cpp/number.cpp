@@ -0,0 +1,41 @@
+#include "number.hpp"
+
+#include <charconv>
+#include <cstdlib>
+#include <string>
+
+
+bool Json::Number::ParseInt(const char *first, const char *last, int64_t &out)
+{
+  auto res = std::from_chars(first, last, out);
+  return res.ec == std::errc() && res.ptr == last;
+}
+
+double Json::Number::ParseFloat(const char *first, const char *last)
+{
+  double val = 0.0;
+  auto   res = std::from_chars(first, last, val);
+  if (res.ec == std::errc::result_out_of_range)
+    return std::strtod(std::string(first, last).c_str(), nullptr);
+
+  return val;
+}
+
+
+size_t Json::Number::Format(int64_t val, char *out)
+{
+  return std::to_chars(out, out + MaxSize, val).ptr - out;
+}
+
+size_t Json::Number::Format(double val, char *out)
+{
+  char *end = std::to_chars(out, out + MaxSize, val).ptr;
+
+  for (char *it = out; it != end; ++it)
+    if (*it == '.' || *it == 'e' || *it == 'n' || *it == 'i')
+      return end - out;
+
+  *end++ = '.';
+  *end++ = '0';
+  return end - out;
+}
@@ -0,0 +1,27 @@
+#ifndef SOURCE_NUMBER_HPP
+#define SOURCE_NUMBER_HPP
+
+
+#include "json.hpp"
+
+
+// Conversions between JSON number text and int64_t/double. Parsing is
+// exact (std::from_chars); floats are printed in the shortest form that
+// reads back to the same double and always keep a '.' or an exponent, so
+// a Float never comes back as an Int.
+class Json::Number
+{
+public:
+
+  static constexpr size_t MaxSize = 32;
+
+  static bool   ParseInt  (const char *first, const char *last, int64_t &out);
+  static double ParseFloat(const char *first, const char *last);
+
+  static size_t Format(int64_t val, char *out);
+  static size_t Format(double  val, char *out);
+
+};
+
+
+#endif // !SOURCE_NUMBER_HPP
@@ -0,0 +1,28 @@
+#include "parser.hpp"
+
+
+std::string Json::make_log(const char *msg, const char *first, const char *pos)
+{
+  uint64_t ln  = 1;
+  uint64_t col = 1;
+  for (const char *it = first; it != pos; ++it) {
+    switch (*it)
+    {
+    case '\r': col = 1;        break;
+    case '\n': col = 1;  ++ln; break;
+    default:
+      if (((uint8_t)*it & 0xC0) != 0x80)
+        ++col;
+      break;
+    }
+  }
+
+  return make_log(msg, ln, col);
+}
+
+std::string Json::make_log(const char *msg, uint64_t ln, uint64_t col)
+{
+  return
+    std::string(msg) +
+    " (ln. " + std::to_string(ln) + ", col. " + std::to_string(col) + ")";
+}
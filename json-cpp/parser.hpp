@@ -0,0 +1,653 @@
+#ifndef SOURCE_PARSER_HPP
+#define SOURCE_PARSER_HPP
+
+
+#include "json.hpp"
+#include "scanner.hpp"
+#include "number.hpp"
+
+#include <string_view>
+
+
+// Single-pass recursive descent parser. The grammar is walked once with a
+// cursor and every token is reported to the handler; nesting deeper than
+// Json::MaxDepth is an error:
+//
+//   static constexpr bool Decode;  // false: only validate, skip conversions
+//   static constexpr bool Filter;  // true: call Select() before values
+//   bool Null  ();
+//   bool Bool  (bool             val);
+//   bool Int   (int64_t          val);
+//   bool Float (double           val);
+//   bool String(std::string_view str);
+//   bool Key   (std::string_view key);
+//   bool StartList  ();
+//   bool EndList    (size_t count);
+//   bool StartStruct();
+//   bool EndStruct  (size_t count);
+//
+// A handler returning false stops the parse. Strings without escapes are
+// passed as views into the input; escaped ones are decoded into a scratch
+// buffer that is only valid until the handler returns (for a key, until
+// the Select() that follows it).
+//
+// With Filter set, bool Select(char first) is called before every struct
+// member value and list element with the value's first character; false
+// skips the value without reporting it. Skipping only matches quotes and
+// brackets, so errors inside a skipped value go unnoticed.
+template <typename Handler>
+class Json::Parser
+{
+public:
+
+  Parser(const char *first, const char *last);
+
+  bool Parse(Handler &handler, std::string *log=nullptr);
+  // Parses input holding only a run of comma-separated list elements
+  // (type '[') or struct members (type '{'), reported as one container.
+  bool ParseRange(Handler &handler, char type);
+
+  bool Aborted() const { return m_aborted; }
+
+  // Input position during a handler call: the opening bracket in
+  // StartList/StartStruct, one past the closing one in EndList/EndStruct.
+  const char* Position() const { return m_cur; }
+
+  // Parses the one value at the start of the input, leaving Position()
+  // just past it; used by Reader to pull values one at a time.
+  bool ParseValue(Handler &handler);
+
+  const char* ErrorMessage () const { return m_message; }
+  const char* ErrorPosition() const { return m_error;   }
+
+private:
+
+  const char  *m_first;
+  const char  *m_last;
+  const char  *m_cur;
+  const char  *m_message;
+  const char  *m_error;
+  Handler     *m_handler;
+  bool         m_aborted;
+  size_t       m_depth;
+  std::string  m_scratch;
+
+
+  static bool is_ws(char ch)
+  {
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+  }
+
+  void skip_ws()
+  {
+    if (m_cur != m_last && is_ws(*m_cur))
+      skip_ws_run();
+  }
+
+  void skip_ws_run();
+
+  bool parse_document();
+  bool parse_value  ();
+  bool parse_literal(const char *lit, size_t len);
+  bool parse_number ();
+  bool parse_string (std::string_view *out);
+  bool parse_list   ();
+  bool parse_struct ();
+  bool parse_member ();
+  bool skip_value   ();
+  bool skip_string  ();
+
+  bool error(const char *msg, const char *pos);
+  bool abort();
+
+};
+
+
+template <typename Handler>
+Json::Parser<Handler>::Parser(const char *first, const char *last) :
+  m_first(first), m_last(last), m_cur(first),
+  m_message(nullptr), m_error(nullptr), m_handler(nullptr), m_aborted(false),
+  m_depth(0)
+{}
+
+
+template <typename Handler>
+bool Json::Parser<Handler>::Parse(Handler &handler, std::string *log)
+{
+  m_cur     = m_first;
+  m_message = nullptr;
+  m_error   = nullptr;
+  m_handler = &handler;
+  m_aborted = false;
+  m_depth   = 0;
+
+  if (parse_document())
+    return true;
+
+  // Failures only record the message and where they happened; the line
+  // and column are counted here, when a log was asked for.
+  if (log && m_message)
+    *log = m_error ? Json::make_log(m_message, m_first, m_error) : m_message;
+  return false;
+}
+
+template <typename Handler>
+bool Json::Parser<Handler>::ParseValue(Handler &handler)
+{
+  m_cur     = m_first;
+  m_message = nullptr;
+  m_error   = nullptr;
+  m_handler = &handler;
+  m_aborted = false;
+  m_depth   = 0;
+
+  return parse_value();
+}
+
+template <typename Handler>
+bool Json::Parser<Handler>::parse_document()
+{
+  skip_ws();
+  if (m_cur == m_last) {
+    m_message = "Empty json";
+    return false;
+  }
+
+  if (!parse_value())
+    return false;
+
+  skip_ws();
+  if (m_cur != m_last)
+    return error("Unknown type", m_cur);
+
+  return true;
+}
+
+
+template <typename Handler>
+bool Json::Parser<Handler>::ParseRange(Handler &handler, char type)
+{
+  m_cur     = m_first;
+  m_message = nullptr;
+  m_error   = nullptr;
+  m_handler = &handler;
+  m_aborted = false;
+  // The range is the inside of a container.
+  m_depth   = 1;
+
+  if (!(type == '[' ? handler.StartList() : handler.StartStruct()))
+    return abort();
+
+  size_t count = 0;
+  for (;;) {
+    skip_ws();
+    if (!(type == '[' ? parse_value() : parse_member()))
+      return false;
+    ++count;
+
+    skip_ws();
+    if (m_cur == m_last)
+      break;
+    if (*m_cur != ',')
+      return false;
+    ++m_cur;
+  }
+
+  if (!(type == '[' ? handler.EndList(count) : handler.EndStruct(count)))
+    return abort();
+  return true;
+}
+
+
+template <typename Handler>
+void Json::Parser<Handler>::skip_ws_run()
+{
+  ++m_cur;
+  if (m_cur != m_last && is_ws(*m_cur))
+    m_cur = Scanner::SkipWhitespace(m_cur, m_last);
+}
+
+template <typename Handler>
+bool Json::Parser<Handler>::parse_value()
+{
+  if (m_cur == m_last)
+    return error("Expected value", m_cur);
+
+  switch (*m_cur)
+  {
+  case '{':
+    return parse_struct();
+  case '[':
+    return parse_list();
+  case '\"': {
+    std::string_view str;
+    if (!parse_string(&str))
+      return false;
+    return m_handler->String(str) || abort();
+  }
+  case 't':
+    return parse_literal("true", 4) && (m_handler->Bool(true) || abort());
+  case 'f':
+    return parse_literal("false", 5) && (m_handler->Bool(false) || abort());
+  case 'n':
+    return parse_literal("null", 4) && (m_handler->Null() || abort());
+  case ',':
+  case ']':
+  case '}':
+    return error("Expected value", m_cur);
+  default:
+    if (
+      (*m_cur >= '0' && *m_cur <= '9') || *m_cur == '-' || *m_cur == '.'
+    ) {
+      return parse_number();
+    }
+    return error("Unknown type", m_cur);
+  }
+}
+
+template <typename Handler>
+bool Json::Parser<Handler>::parse_literal(const char *lit, size_t len)
+{
+  if ((size_t)(m_last - m_cur) < len)
+    return error("Unknown type", m_cur);
+
+  for (size_t i = 0; i < len; ++i)
+    if (m_cur[i] != lit[i])
+      return error("Unknown type", m_cur);
+
+  m_cur += len;
+  return true;
+}
+
+template <typename Handler>
+bool Json::Parser<Handler>::parse_number()
+{
+  const auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+
+  const char *st       = m_cur;
+  bool        is_float = false;
+  bool        negative = *m_cur == '-';
+  size_t      digits   = 0;
+  uint64_t    mantissa = 0;
+
+  if (negative)
+    ++m_cur;
+
+  for (; m_cur != m_last && is_digit(*m_cur); ++m_cur) {
+    mantissa = mantissa * 10 + (uint64_t)(*m_cur - '0');
+    ++digits;
+  }
+
+  if (m_cur != m_last && *m_cur == '.') {
+    is_float = true;
+    for (++m_cur; m_cur != m_last && is_digit(*m_cur); ++m_cur)
+      ++digits;
+  }
+
+  if (digits == 0)
+    return error("Unknown type", st);
+
+  if (m_cur != m_last && (*m_cur == 'e' || *m_cur == 'E')) {
+    is_float = true;
+    ++m_cur;
+    if (m_cur != m_last && (*m_cur == '+' || *m_cur == '-'))
+      ++m_cur;
+
+    if (m_cur == m_last || !is_digit(*m_cur))
+      return error("Unknown type", st);
+
+    while (m_cur != m_last && is_digit(*m_cur))
+      ++m_cur;
+  }
+
+  if constexpr (!Handler::Decode) {
+    return m_handler->Float(0.0) || abort();
+  }
+  else {
+    if (!is_float) {
+      // Up to 18 digits cannot overflow the accumulated mantissa.
+      if (digits <= 18) {
+        int64_t val = (int64_t)mantissa;
+        return m_handler->Int(negative ? -val : val) || abort();
+      }
+
+      int64_t val;
+      if (Number::ParseInt(st, m_cur, val))
+        return m_handler->Int(val) || abort();
+    }
+
+    return m_handler->Float(Number::ParseFloat(st, m_cur)) || abort();
+  }
+}
+
+template <typename Handler>
+bool Json::Parser<Handler>::parse_string(std::string_view *out)
+{
+  const auto hex = [](char c) -> int
+  {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+  };
+
+  const auto read_u = [&](const char *pos, uint32_t &cp)
+  {
+    if (m_last - pos < 4)
+      return false;
+
+    cp = 0;
+    for (int i = 0; i < 4; ++i) {
+      int d = hex(pos[i]);
+      if (d < 0)
+        return false;
+      cp = (cp << 4) | (uint32_t)d;
+    }
+    return true;
+  };
+
+  const char *first   = ++m_cur;
+  const char *run     = first;
+  bool        escaped = false;
+
+  for (;;) {
+    m_cur = Scanner::FindQuote(m_cur, m_last);
+    if (m_cur == m_last)
+      return error("Expected \'\"\'", m_cur);
+
+    if (*m_cur == '\"')
+      break;
+
+    if (!escaped) {
+      escaped = true;
+      m_scratch.clear();
+    }
+    if constexpr (Handler::Decode)
+      m_scratch.append(run, m_cur);
+
+    const char *esc = m_cur++;
+    if (m_cur == m_last)
+      return error("Expected \'\"\'", m_cur);
+
+    char ch;
+    switch (*m_cur)
+    {
+    case '\"': ch = '\"'; break;
+    case '\\': ch = '\\'; break;
+    case '/':  ch = '/';  break;
+    case 'b':  ch = '\b'; break;
+    case 'f':  ch = '\f'; break;
+    case 'n':  ch = '\n'; break;
+    case 'r':  ch = '\r'; break;
+    case 't':  ch = '\t'; break;
+    case 'u': {
+      uint32_t cp;
+      if (!read_u(m_cur + 1, cp))
+        return error("Invalid escape sequence", esc);
+      m_cur += 4;
+
+      uint32_t lo;
+      if (
+        cp >= 0xD800 && cp <= 0xDBFF &&
+        m_last - m_cur >= 3 && m_cur[1] == '\\' && m_cur[2] == 'u' &&
+        read_u(m_cur + 3, lo) && lo >= 0xDC00 && lo <= 0xDFFF
+      ) {
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+        m_cur += 6;
+      }
+
+      if constexpr (Handler::Decode) {
+        char buf[4];
+        m_scratch.append(buf, Json::encode_utf8(cp, buf));
+      }
+      run = ++m_cur;
+      continue;
+    }
+    default:
+      return error("Invalid escape sequence", esc);
+    }
+
+    if constexpr (Handler::Decode)
+      m_scratch.push_back(ch);
+    run = ++m_cur;
+  }
+
+  if (!escaped) {
+    *out = std::string_view(first, m_cur - first);
+  }
+  else {
+    if constexpr (Handler::Decode)
+      m_scratch.append(run, m_cur);
+    *out = m_scratch;
+  }
+
+  ++m_cur;
+  return true;
+}
+
+template <typename Handler>
+bool Json::Parser<Handler>::parse_list()
+{
+  if (m_depth == MaxDepth)
+    return error("Nesting too deep", m_cur);
+  if (!m_handler->StartList())
+    return abort();
+  ++m_depth;
+
+  size_t count = 0;
+
+  ++m_cur;
+  skip_ws();
+  if (m_cur != m_last && *m_cur == ']') {
+    ++m_cur;
+    --m_depth;
+    return m_handler->EndList(count) || abort();
+  }
+
+  for (;;) {
+    skip_ws();
+    if constexpr (Handler::Filter) {
+      if (m_cur != m_last && !m_handler->Select(*m_cur)) {
+        if (!skip_value())
+          return false;
+      }
+      else if (!parse_value()) {
+        return false;
+      }
+    }
+    else if (!parse_value()) {
+      return false;
+    }
+    ++count;
+
+    skip_ws();
+    if (m_cur == m_last)
+      return error("Expected ']'", m_cur);
+
+    if (*m_cur == ']') {
+      ++m_cur;
+      --m_depth;
+      return m_handler->EndList(count) || abort();
+    }
+    if (*m_cur != ',')
+      return error("Expected ']'", m_cur);
+    ++m_cur;
+  }
+}
+
+template <typename Handler>
+bool Json::Parser<Handler>::parse_struct()
+{
+  if (m_depth == MaxDepth)
+    return error("Nesting too deep", m_cur);
+  if (!m_handler->StartStruct())
+    return abort();
+  ++m_depth;
+
+  size_t count = 0;
+
+  ++m_cur;
+  skip_ws();
+  if (m_cur != m_last && *m_cur == '}') {
+    ++m_cur;
+    --m_depth;
+    return m_handler->EndStruct(count) || abort();
+  }
+
+  for (;;) {
+    skip_ws();
+    if (!parse_member())
+      return false;
+    ++count;
+
+    skip_ws();
+    if (m_cur == m_last)
+      return error("Expected '}'", m_cur);
+
+    if (*m_cur == '}') {
+      ++m_cur;
+      --m_depth;
+      return m_handler->EndStruct(count) || abort();
+    }
+    if (*m_cur != ',')
+      return error("Expected '}'", m_cur);
+    ++m_cur;
+  }
+}
+
+
+template <typename Handler>
+bool Json::Parser<Handler>::parse_member()
+{
+  if (m_cur == m_last || *m_cur == '}')
+    return error("Expected property", m_cur);
+  if (*m_cur != '\"')
+    return error("Expected \'\"\'", m_cur);
+
+  std::string_view key;
+  if (!parse_string(&key))
+    return false;
+  if (!m_handler->Key(key))
+    return abort();
+
+  skip_ws();
+  if (m_cur == m_last || *m_cur != ':')
+    return error("Expected \':\'", m_cur);
+  ++m_cur;
+
+  skip_ws();
+  if constexpr (Handler::Filter) {
+    if (m_cur != m_last && !m_handler->Select(*m_cur))
+      return skip_value();
+  }
+  return parse_value();
+}
+
+
+template <typename Handler>
+bool Json::Parser<Handler>::skip_value()
+{
+  if (*m_cur == '\"')
+    return skip_string();
+
+  const char *st = m_cur;
+
+  if (*m_cur != '[' && *m_cur != '{') {
+    while (
+      m_cur != m_last && *m_cur != ',' && *m_cur != ']' && *m_cur != '}' &&
+      !is_ws(*m_cur)
+    ) {
+      ++m_cur;
+    }
+    return m_cur != st || error("Expected value", m_cur);
+  }
+
+  size_t depth = 0;
+  while (m_cur != m_last) {
+    switch (*m_cur)
+    {
+    case '\"':
+      if (!skip_string())
+        return false;
+      continue;
+    case '[':
+    case '{':
+      ++depth;
+      break;
+    case ']':
+    case '}':
+      if (--depth == 0) {
+        ++m_cur;
+        return true;
+      }
+      break;
+    default:
+      break;
+    }
+    ++m_cur;
+  }
+
+  return error(*st == '[' ? "Expected ']'" : "Expected '}'", m_cur);
+}
+
+template <typename Handler>
+bool Json::Parser<Handler>::skip_string()
+{
+  for (++m_cur;;) {
+    m_cur = Scanner::FindQuote(m_cur, m_last);
+    if (m_cur == m_last)
+      return error("Expected \'\"\'", m_cur);
+
+    if (*m_cur == '\"') {
+      ++m_cur;
+      return true;
+    }
+    if (m_last - m_cur < 2) {
+      m_cur = m_last;
+      return error("Expected \'\"\'", m_cur);
+    }
+    m_cur += 2;
+  }
+}
+
+
+template <typename Handler>
+bool Json::Parser<Handler>::error(const char *msg, const char *pos)
+{
+  m_message = msg;
+  m_error   = pos;
+  return false;
+}
+
+template <typename Handler>
+bool Json::Parser<Handler>::abort()
+{
+  m_aborted = true;
+  return false;
+}
+
+
+// Handler that accepts everything; used to validate without building.
+class Json::NullHandler
+{
+public:
+
+  static constexpr bool Decode = false;
+  static constexpr bool Filter = false;
+
+  bool Null  ()                 { return true; }
+  bool Bool  (bool)             { return true; }
+  bool Int   (int64_t)          { return true; }
+  bool Float (double)           { return true; }
+  bool String(std::string_view) { return true; }
+  bool Key   (std::string_view) { return true; }
+
+  bool StartList  ()       { return true; }
+  bool EndList    (size_t) { return true; }
+  bool StartStruct()       { return true; }
+  bool EndStruct  (size_t) { return true; }
+
+};
+
+
+#endif // !SOURCE_PARSER_HPP
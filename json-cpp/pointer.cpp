@@ -0,0 +1,70 @@
+#include "pointer.hpp"
+#include "property.hpp"
+#include "key_index.hpp"
+
+
+Json::Pointer::Pointer()
+{}
+
+Json::Pointer::Pointer(std::string_view pointer)
+{
+  if (pointer.empty())
+    return;
+  if (pointer[0] != '/')
+    throw Value::BadPointer;
+
+  size_t pos = 1;
+  for (;;) {
+    size_t end = pointer.find('/', pos);
+    if (end == std::string_view::npos)
+      end = pointer.size();
+
+    Token token;
+    for (size_t i = pos; i < end; ++i) {
+      char c = pointer[i];
+      if (c == '~') {
+        if (i + 1 == end || (pointer[i + 1] != '0' && pointer[i + 1] != '1'))
+          throw Value::BadPointer;
+        c = pointer[++i] == '0' ? '~' : '/';
+      }
+      token.name.push_back(c);
+    }
+
+    // Array indices are "0" or digits without a leading zero.
+    const std::string &name = token.name;
+    token.hash  = KeyIndex::Hash(name);
+    token.index = NoIndex;
+    if (name == "-") {
+      token.index = End;
+    }
+    else if (
+      !name.empty() && name.size() <= 18 && (name[0] != '0' || name.size() == 1) &&
+      name.find_first_not_of("0123456789") == std::string::npos
+    ) {
+      token.index = std::stoull(name);
+    }
+
+    m_tokens.push_back(std::move(token));
+    if (end == pointer.size())
+      break;
+    pos = end + 1;
+  }
+}
+
+
+std::string Json::Pointer::ToString() const
+{
+  std::string out;
+  for (const Token &token : m_tokens) {
+    out.push_back('/');
+    for (char c : token.name) {
+      if (c == '~')
+        out += "~0";
+      else if (c == '/')
+        out += "~1";
+      else
+        out.push_back(c);
+    }
+  }
+  return out;
+}
@@ -0,0 +1,54 @@
+#ifndef SOURCE_POINTER_HPP
+#define SOURCE_POINTER_HPP
+
+
+#include "json.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+// Compiled RFC 6901 JSON Pointer. The reference tokens are unescaped, and
+// property names hashed, once; evaluating the pointer against a Value then
+// costs one index probe per token:
+//
+//   static const Json::Pointer path("/routes/0/path");
+//   const Json::Value *val = request.Find(path);
+//
+// "" refers to the whole value. The token "-" names the position after
+// the last list element and is only accepted by Value::Set.
+class Json::Pointer
+{
+public:
+
+  Pointer();
+  // Throws Value::BadPointer when pointer is neither empty nor starts
+  // with '/', or holds a '~' not followed by '0' or '1'.
+  explicit Pointer(std::string_view pointer);
+
+  size_t      Size    () const { return m_tokens.size(); }
+  std::string ToString() const;
+
+private:
+
+  static constexpr size_t NoIndex = (size_t)-1;
+  static constexpr size_t End     = (size_t)-2;
+
+  struct Token
+  {
+    std::string name;
+    size_t      hash;
+    // List index the token spells, End for "-", otherwise NoIndex.
+    size_t      index;
+  };
+
+  std::vector<Token> m_tokens;
+
+  friend class Json::Value;
+  friend class Json::Projection;
+
+};
+
+
+#endif // !SOURCE_POINTER_HPP
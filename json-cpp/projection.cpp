@@ -0,0 +1,161 @@
+#include "projection.hpp"
+#include "property.hpp"
+#include "pointer.hpp"
+#include "parser.hpp"
+#include "dom_builder.hpp"
+
+
+// Forwards the values on a projected path to a DomBuilder and has the
+// parser skip the rest.
+class Json::Projection::Builder
+{
+public:
+
+  static constexpr bool Decode = true;
+  static constexpr bool Filter = true;
+
+  Builder(
+    const Node *root, Value *out, std::pmr::memory_resource *res,
+    KeyTable *keys
+  ) :
+    m_dom(out, res, keys), m_next(root)
+  {}
+
+  bool Null  ()                     { return !keep() || m_dom.Null();      }
+  bool Bool  (bool             val) { return !keep() || m_dom.Bool(val);   }
+  bool Int   (int64_t          val) { return !keep() || m_dom.Int(val);    }
+  bool Float (double           val) { return !keep() || m_dom.Float(val);  }
+  bool String(std::string_view str) { return !keep() || m_dom.String(str); }
+  bool Key   (std::string_view key) { m_key = key; return true; }
+
+  bool StartList  ()             { return open(false) && m_dom.StartList(); }
+  bool EndList    (size_t count) { m_stack.pop_back(); return m_dom.EndList(count); }
+  bool StartStruct()             { return open(true) && m_dom.StartStruct(); }
+  bool EndStruct  (size_t count) { m_stack.pop_back(); return m_dom.EndStruct(count); }
+
+  bool Select(char first)
+  {
+    Frame      &top  = m_stack.back();
+    const Node *node = top.node;
+
+    if (!node->all) {
+      node = top.is_struct ? node->Find(m_key) : node->Element(top.index++);
+      // Paths going deeper than the document are not followed.
+      if (!node || (!node->all && first != '[' && first != '{'))
+        return false;
+    }
+
+    m_next = node;
+    return !top.is_struct || m_dom.Key(m_key);
+  }
+
+private:
+
+  struct Frame
+  {
+    const Node *node;
+    bool        is_struct;
+    size_t      index;
+  };
+
+  DomBuilder         m_dom;
+  std::vector<Frame> m_stack;
+  const Node        *m_next;
+  std::string_view   m_key;
+
+
+  // Select() has already filtered values inside containers; a scalar root
+  // is only kept when the empty path "" was projected.
+  bool keep() const
+  {
+    return !m_stack.empty() || m_next->all;
+  }
+
+  bool open(bool is_struct)
+  {
+    m_stack.push_back({ m_next, is_struct, 0 });
+    return true;
+  }
+
+};
+
+
+Json::Projection::Projection() :
+  m_root{ std::string(), Pointer::NoIndex, false, {} }
+{}
+
+Json::Projection::Projection(std::initializer_list<std::string_view> paths) :
+  Projection()
+{
+  for (std::string_view path : paths)
+    Add(path);
+}
+
+
+void Json::Projection::Add(const Pointer &path)
+{
+  Node *node = &m_root;
+  for (const Pointer::Token &token : path.m_tokens) {
+    if (node->all)
+      return;
+
+    Node *child = nullptr;
+    for (Node &n : node->children) {
+      if (n.name == token.name) {
+        child = &n;
+        break;
+      }
+    }
+    if (!child) {
+      size_t index = token.index == Pointer::End ? Pointer::NoIndex : token.index;
+      node->children.push_back({ token.name, index, false, {} });
+      child = &node->children.back();
+    }
+    node = child;
+  }
+
+  node->all = true;
+  node->children.clear();
+}
+
+void Json::Projection::Add(std::string_view path)
+{
+  Add(Pointer(path));
+}
+
+
+const Json::Projection::Node* Json::Projection::Node::Find(std::string_view name) const
+{
+  for (const Node &n : children)
+    if (n.name == name)
+      return &n;
+
+  return nullptr;
+}
+
+// An element is kept by its own index token, or followed with this node
+// when name tokens below it apply to every element.
+const Json::Projection::Node* Json::Projection::Node::Element(size_t i) const
+{
+  bool by_name = false;
+  for (const Node &n : children) {
+    if (n.index == i)
+      return &n;
+    if (n.index == Pointer::NoIndex)
+      by_name = true;
+  }
+
+  return by_name ? this : nullptr;
+}
+
+
+bool Json::Projection::parse(
+  std::string_view json_str, Value *out, std::pmr::memory_resource *res,
+  KeyTable *keys
+) const
+{
+  Builder builder(&m_root, out, res, keys);
+  return Parser<Builder>(
+    json_str.data(), json_str.data() + json_str.size()
+  ).Parse(builder);
+}
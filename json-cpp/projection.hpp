@@ -0,0 +1,65 @@
+#ifndef SOURCE_PROJECTION_HPP
+#define SOURCE_PROJECTION_HPP
+
+
+#include "json.hpp"
+
+#include <string>
+#include <string_view>
+#include <initializer_list>
+#include <vector>
+
+
+// Set of JSON Pointer paths a document is loaded through. Members and
+// elements off every path are skipped by matching quotes and brackets
+// only, without decoding them or building values:
+//
+//   static const Json::Projection fields{ "/id", "/ts", "/user/region" };
+//   json.LoadFromString(event, fields);
+//
+// A name token applies to every element of a list it meets, so
+// "/items/price" keeps the price of each item, while an index token keeps
+// a single element. "" keeps the whole document; without it a scalar
+// document loads as null. Syntax errors inside skipped values are not
+// reported.
+class Json::Projection
+{
+public:
+
+  Projection();
+  // Throws Value::BadPointer like Pointer(std::string_view).
+  Projection(std::initializer_list<std::string_view> paths);
+
+  void Add(const Pointer    &path);
+  void Add(std::string_view  path);
+
+private:
+
+  class Builder;
+
+  struct Node
+  {
+    std::string       name;
+    size_t            index;
+    // The path ends here: keep the whole value.
+    bool              all;
+    std::vector<Node> children;
+
+    const Node* Find   (std::string_view name) const;
+    const Node* Element(size_t           i)    const;
+  };
+
+  Node m_root;
+
+
+  bool parse(
+    std::string_view json_str, Value *out,
+    std::pmr::memory_resource *res, KeyTable *keys
+  ) const;
+
+  friend class Json;
+
+};
+
+
+#endif // !SOURCE_PROJECTION_HPP
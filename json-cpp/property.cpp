@@ -1,11 +1,145 @@
 #include "property.hpp"
 
+#include <cstring>
+#include <stdexcept>
+
 
 Json::Property::Property(const std::wstring &name, const Value &val) :
-  m_name(name), m_value(val)
+  Property(Json::to_str(name), val)
 {}
 
 Json::Property::Property(const std::string &name, const Value &val) :
-  m_name(name.begin(), name.end()), m_value(val)
-{}
+  m_kind(INLINE), m_value(val)
+{
+  set_name(name, std::pmr::get_default_resource());
+}
+
+Json::Property::Property(const std::string &name, Value &&val) :
+  m_kind(INLINE), m_value(std::move(val))
+{
+  set_name(name, std::pmr::get_default_resource());
+}
+
+Json::Property::Property(const char *name, const Value &val) :
+  m_kind(INLINE), m_value(val)
+{
+  set_name(name, std::pmr::get_default_resource());
+}
+
+Json::Property::Property(const char *name, Value &&val) :
+  m_kind(INLINE), m_value(std::move(val))
+{
+  set_name(name, std::pmr::get_default_resource());
+}
+
+Json::Property::Property(StringType &&name, Value &&val) :
+  m_kind(INLINE), m_value(std::move(val))
+{
+  set_name(name, name.get_allocator().resource());
+}
+
+Json::Property::Property(
+  std::string_view name, std::pmr::memory_resource *res, Value &&val
+) :
+  m_kind(INLINE), m_value(std::move(val))
+{
+  if (res) {
+    set_name(name, res);
+    return;
+  }
+
+  m_heap.ptr = name.data();
+  m_heap.res = nullptr;
+  m_size     = (uint32_t)name.size();
+  m_kind     = INTERNED;
+}
+
+Json::Property::Property(const Property &prop) :
+  m_kind(INLINE), m_value(prop.m_value)
+{
+  set_name(prop.GetNameView(), std::pmr::get_default_resource());
+}
+
+Json::Property::Property(Property &&prop) noexcept :
+  m_value(std::move(prop.m_value))
+{
+  take(prop);
+}
+
+Json::Property::~Property()
+{
+  release();
+}
+
+
+Json::Property& Json::Property::operator=(const Property &prop)
+{
+  if (this != &prop) {
+    Property copy(prop);
+    *this = std::move(copy);
+  }
+  return *this;
+}
+
+Json::Property& Json::Property::operator=(Property &&prop) noexcept
+{
+  if (this != &prop) {
+    // prop may live inside this property's value.
+    Property tmp(std::move(prop));
+    release();
+    take(tmp);
+    m_value = std::move(tmp.m_value);
+  }
+  return *this;
+}
+
+
+void Json::Property::SetName(const std::string &name)
+{
+  std::pmr::memory_resource *res = m_kind == OWNED ?
+    m_heap.res : std::pmr::get_default_resource();
+
+  Property copy(name, res, Value());
+  release();
+  take(copy);
+}
+
+
+void Json::Property::set_name(std::string_view name, std::pmr::memory_resource *res)
+{
+  if (name.size() > UINT32_MAX)
+    throw std::length_error("Json::Property name is too long");
+
+  m_size = (uint32_t)name.size();
+  if (name.size() <= InlineSize) {
+    std::memcpy(m_buf, name.data(), name.size());
+    m_kind = INLINE;
+    return;
+  }
+
+  char *copy = (char*)res->allocate(name.size(), 1);
+  std::memcpy(copy, name.data(), name.size());
+
+  m_heap.ptr = copy;
+  m_heap.res = res;
+  m_kind     = OWNED;
+}
+
+void Json::Property::release()
+{
+  if (m_kind == OWNED)
+    m_heap.res->deallocate((void*)m_heap.ptr, m_size, 1);
+
+  m_size = 0;
+  m_kind = INLINE;
+}
+
+void Json::Property::take(Property &prop) noexcept
+{
+  std::memcpy(m_buf, prop.m_buf, InlineSize);
+  m_size = prop.m_size;
+  m_kind = prop.m_kind;
 
+  prop.m_size = 0;
+  prop.m_kind = INLINE;
+}
@@ -5,40 +5,188 @@
 #include "json.hpp"
 #include "value.hpp"
 
+#include <string_view>
+#include <tuple>
 
+
+// Names of up to InlineSize bytes are stored inside the property. Longer
+// names are allocated from a memory resource, or point into a KeyTable
+// when the document was parsed with one.
 class Json::Property
 {
 public:
-  
-  Property(const std::wstring &name, const Value &val);
-  Property(const std::string  &name, const Value &val);
 
-  std::string  GetName () const { return Json::to_str(m_name); }
-  std::wstring GetNameW() const { return m_name; }
+  static constexpr size_t InlineSize = 16;
+
+  Property(const std::wstring &name, const Value  &val);
+  Property(const std::string  &name, const Value  &val);
+  Property(const std::string  &name, Value       &&val);
+  Property(const char         *name, const Value  &val);
+  Property(const char         *name, Value       &&val);
+  Property(StringType        &&name, Value       &&val);
+
+  Property(const Property  &prop);
+  Property(Property       &&prop) noexcept;
+  ~Property();
+
+  Property& operator=(const Property  &prop);
+  Property& operator=(Property       &&prop) noexcept;
+
+  std::string  GetName () const { return std::string(GetNameView()); }
+  std::wstring GetNameW() const { return Json::to_wstr(GetNameView()); }
+
+  std::string_view GetNameView() const
+  {
+    return std::string_view(m_kind == INLINE ? m_buf : m_heap.ptr, m_size);
+  }
 
-  void SetName(const std::string  &name) { m_name = std::wstring(name.begin(), name.end()); }
-  void SetName(const std::wstring &name) { m_name = name; }
+  bool IsInterned() const { return m_kind == INTERNED; }
+
+  void SetName(const std::string  &name);
+  void SetName(const std::wstring &name) { SetName(Json::to_str(name)); }
 
   Value&        GetValue()       { return m_value; }
   const Value&  GetValue() const { return m_value; }
 
+  // Structured bindings: for (auto &[name, val] : obj.GetStructView())
+  template <size_t I>
+  decltype(auto) get()
+  {
+    static_assert(I < 2, "Json::Property has two elements");
+    if constexpr (I == 0)
+      return GetNameView();
+    else
+      return (m_value);
+  }
+
+  template <size_t I>
+  decltype(auto) get() const
+  {
+    static_assert(I < 2, "Json::Property has two elements");
+    if constexpr (I == 0)
+      return GetNameView();
+    else
+      return (m_value);
+  }
+
+private:
+
+  enum Kind : uint32_t
+  {
+    INLINE,
+    OWNED,
+    INTERNED
+  };
+
+  union
+  {
+    char m_buf[InlineSize];
+    struct
+    {
+      const char                *ptr;
+      std::pmr::memory_resource *res;
+    } m_heap;
+  };
+  uint32_t m_size;
+  Kind     m_kind;
+  Value    m_value;
+
+
+  // A null res stores name as an interned pointer without copying it.
+  Property(std::string_view name, std::pmr::memory_resource *res, Value &&val);
+
+  void set_name(std::string_view name, std::pmr::memory_resource *res);
+  void release ();
+  void take    (Property &prop) noexcept;
+
+  friend class Json::Value;
+  friend class Json::DomBuilder;
+  friend class Json::KeyIndex;
+  friend class Json::Writer;
+};
+
+
+template <>
+struct std::tuple_size<Json::Property> : std::integral_constant<size_t, 2>
+{};
+
+template <>
+struct std::tuple_element<0, Json::Property>
+{
+  using type = std::string_view;
+};
+
+template <>
+struct std::tuple_element<1, Json::Property>
+{
+  using type = Json::Value;
+};
+
+
+// Contiguous read-only range of struct properties in insertion order.
+class Json::Value::StructView
+{
+public:
+
+  StructView() : m_data(nullptr) {}
+
+  const Property* begin() const { return m_data ? m_data->props.data() : nullptr; }
+  const Property* end  () const { return begin() + Size(); }
+
+  size_t Size () const { return m_data ? m_data->props.size() : 0; }
+  bool   Empty() const { return Size() == 0; }
+
+  const Property& operator[](size_t i) const { return m_data->props[i]; }
+
+  // Null when there is no such property.
+  const Value* Find(std::string_view prop_name) const
+  {
+    if (!m_data)
+      return nullptr;
+
+    size_t i = m_data->index.Find(m_data->props, prop_name);
+    return i == KeyIndex::npos ? nullptr : &m_data->props[i].GetValue();
+  }
+
 private:
 
-  std::wstring m_name;
-  Value        m_value;
-
-  friend bool         Json::validate_property(
-    const std::wstring &json_str, std::string *log, uint64_t ln, uint64_t col
-  );
-  friend std::wstring Json::serialize_property(
-    const Property     &prop
-  );
-  friend void         Json::deserialize_property(
-    const std::wstring &json_str, Property *prop
-  );
+  const StructData *m_data;
+
+
+  explicit StructView(const StructData *data) : m_data(data) {}
+
+  friend class Json::Value;
+
 };
 
 
+template <typename Visitor>
+auto Json::Value::Visit(Visitor &&vis) const
+  -> std::invoke_result_t<Visitor, std::nullptr_t>
+{
+  switch (m_type)
+  {
+  case Bool:
+    return std::forward<Visitor>(vis)(m_bool);
+  case Int:
+    return std::forward<Visitor>(vis)(m_int);
+  case Float:
+    return std::forward<Visitor>(vis)(m_float);
+  case String:
+    return std::forward<Visitor>(vis)(std::string_view(*(StringType*)m_value));
+  case List: {
+    auto *list = (ListType*)m_value;
+    return std::forward<Visitor>(vis)(
+      ListView(list->data(), list->data() + list->size())
+    );
+  }
+  case Struct:
+    return std::forward<Visitor>(vis)(StructView((StructData*)m_value));
+  default:
+    return std::forward<Visitor>(vis)(nullptr);
+  }
+}
+
 
 #endif // !SOURCE_PROPERTY_HPP
 
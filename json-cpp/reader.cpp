@@ -0,0 +1,339 @@
+#include "reader.hpp"
+#include "parser.hpp"
+#include "dom_builder.hpp"
+#include "property.hpp"
+#include "scanner.hpp"
+
+#include <charconv>
+#include <cmath>
+
+
+// Keeps the scalar the parser reports.
+class Json::Reader::Sink
+{
+public:
+
+  explicit Sink(Reader &reader) : m_reader(reader) {}
+
+  static constexpr bool Decode = true;
+  static constexpr bool Filter = false;
+
+  ValueType        type = Json::Null;
+  bool             b    = false;
+  int64_t          i    = 0;
+  double           f    = 0.0;
+  std::string_view str;
+
+  bool Null  ()                   { type = Json::Null;   return true; }
+  bool Bool  (bool             v) { type = Json::Bool;   b   = v; return true; }
+  bool Int   (int64_t          v) { type = Json::Int;    i   = v; return true; }
+  bool Float (double           v) { type = Json::Float;  f   = v; return true; }
+  bool String(std::string_view v)
+  {
+    type = Json::String;
+    str  = v;
+    // Escaped strings are decoded into a buffer that goes away with the
+    // parser.
+    if (v.data() < m_reader.m_first || v.data() >= m_reader.m_last) {
+      m_reader.m_scratch.assign(v);
+      str = m_reader.m_scratch;
+    }
+    return true;
+  }
+  bool Key   (std::string_view)   { return true; }
+
+  bool StartList  ()       { return true; }
+  bool EndList    (size_t) { return true; }
+  bool StartStruct()       { return true; }
+  bool EndStruct  (size_t) { return true; }
+
+private:
+
+  Reader &m_reader;
+
+};
+
+
+Json::Reader::Reader(std::string_view json) :
+  m_first(json.data()), m_cur(json.data()), m_last(json.data() + json.size()),
+  m_message(nullptr), m_error(nullptr), m_fresh(false), m_depth(0)
+{}
+
+
+bool Json::Reader::ReadNull()
+{
+  char ch;
+  if (!peek(ch) || ch != 'n')
+    return false;
+
+  Sink sink(*this);
+  return parse(sink);
+}
+
+bool Json::Reader::ReadBool(bool &out)
+{
+  Sink sink(*this);
+  if (!scalar(sink, Json::Bool, "Expected bool"))
+    return false;
+
+  out = sink.b;
+  return true;
+}
+
+bool Json::Reader::ReadInt(int64_t &out, int64_t min, int64_t max)
+{
+  Sink sink(*this);
+  const char *st = Scanner::SkipWhitespace(m_cur, m_last);
+  if (!scalar(sink, Json::Int, "Expected integer"))
+    return false;
+  if (!range(st, sink.i >= min && sink.i <= max))
+    return false;
+
+  out = sink.i;
+  return true;
+}
+
+bool Json::Reader::ReadUInt(uint64_t &out, uint64_t max)
+{
+  Sink sink(*this);
+  const char *st = Scanner::SkipWhitespace(m_cur, m_last);
+  if (!scalar(sink, Json::Float, "Expected integer"))
+    return false;
+
+  if (sink.type == Json::Int) {
+    if (!range(st, sink.i >= 0 && (uint64_t)sink.i <= max))
+      return false;
+    out = (uint64_t)sink.i;
+    return true;
+  }
+
+  // Reread the digits, which the float has rounded.
+  uint64_t val;
+  auto     res = std::from_chars(st, m_cur, val);
+  if (res.ptr != m_cur && res.ec != std::errc::result_out_of_range) {
+    m_cur = st;
+    return Error("Expected integer");
+  }
+  if (!range(st, res.ec == std::errc() && val <= max))
+    return false;
+
+  out = val;
+  return true;
+}
+
+bool Json::Reader::ReadFloat(double &out, double max)
+{
+  Sink sink(*this);
+  const char *st = Scanner::SkipWhitespace(m_cur, m_last);
+  if (!scalar(sink, Json::Float, "Expected number"))
+    return false;
+
+  double val = sink.type == Json::Int ? (double)sink.i : sink.f;
+  if (!(std::fabs(val) <= max)) {
+    m_cur = st;
+    return Error("Number out of range");
+  }
+
+  out = val;
+  return true;
+}
+
+bool Json::Reader::ReadString(std::string_view &out)
+{
+  Sink sink(*this);
+  if (!scalar(sink, Json::String, "Expected string"))
+    return false;
+
+  out = sink.str;
+  return true;
+}
+
+bool Json::Reader::ReadValue(Value &out)
+{
+  char ch;
+  if (!peek(ch))
+    return false;
+
+  out = Value();
+  DomBuilder builder(&out);
+  return parse(builder);
+}
+
+
+bool Json::Reader::StartList()
+{
+  return expect('[', "Expected list");
+}
+
+bool Json::Reader::NextElement()
+{
+  return next(']');
+}
+
+bool Json::Reader::StartStruct()
+{
+  return expect('{', "Expected struct");
+}
+
+bool Json::Reader::NextMember(std::string_view &key)
+{
+  char ch;
+  if (!next('}') || !peek(ch))
+    return false;
+  if (ch != '\"')
+    return Error("Expected property");
+
+  Sink sink(*this);
+  if (!parse(sink))
+    return false;
+
+  key = sink.str;
+
+  if (!peek(ch))
+    return false;
+  if (ch != ':')
+    return Error("Expected \':\'");
+  ++m_cur;
+  return true;
+}
+
+
+bool Json::Reader::Skip()
+{
+  char ch;
+  if (!peek(ch))
+    return false;
+
+  NullHandler handler;
+  return parse(handler);
+}
+
+bool Json::Reader::Finish()
+{
+  if (Failed())
+    return false;
+
+  m_cur = Scanner::SkipWhitespace(m_cur, m_last);
+  return m_cur == m_last || Error("Unknown type");
+}
+
+
+bool Json::Reader::Error(const char *msg)
+{
+  if (!Failed()) {
+    m_message = msg;
+    m_error   = m_cur;
+  }
+  return false;
+}
+
+std::string Json::Reader::GetLog() const
+{
+  if (!m_message)
+    return std::string();
+
+  return Json::make_log(m_message, m_first, m_error);
+}
+
+
+// Moves to the next value and reads its first character.
+bool Json::Reader::peek(char &ch)
+{
+  if (Failed())
+    return false;
+
+  m_cur = Scanner::SkipWhitespace(m_cur, m_last);
+  if (m_cur == m_last)
+    return Error("Expected value");
+
+  ch = *m_cur;
+  return true;
+}
+
+bool Json::Reader::expect(char ch, const char *msg)
+{
+  char next_ch;
+  if (!peek(next_ch))
+    return false;
+  if (next_ch != ch)
+    return Error(msg);
+  if (m_depth == MaxDepth)
+    return Error("Nesting too deep");
+
+  ++m_cur;
+  ++m_depth;
+  m_fresh = true;
+  return true;
+}
+
+// Steps over the ',' before an element or member, or the closing
+// bracket after the last one.
+bool Json::Reader::next(char close)
+{
+  char ch;
+  if (!peek(ch))
+    return false;
+
+  if (ch == close) {
+    ++m_cur;
+    --m_depth;
+    m_fresh = false;
+    return false;
+  }
+
+  if (m_fresh) {
+    m_fresh = false;
+    return true;
+  }
+  if (ch != ',')
+    return Error(close == ']' ? "Expected ']'" : "Expected '}'");
+
+  ++m_cur;
+  return true;
+}
+
+// Parses a scalar of the given type, where Float also takes integers. A
+// value of another type is reported at its start.
+bool Json::Reader::scalar(Sink &sink, ValueType type, const char *msg)
+{
+  char ch;
+  if (!peek(ch))
+    return false;
+  if (ch == '[' || ch == '{')
+    return Error(msg);
+
+  const char *st = m_cur;
+  if (!parse(sink))
+    return false;
+  if (sink.type == type || (type == Json::Float && sink.type == Json::Int))
+    return true;
+
+  m_cur = st;
+  return Error(msg);
+}
+
+// Reports an integer outside the caller's range at its first digit.
+bool Json::Reader::range(const char *st, bool fits)
+{
+  if (fits)
+    return true;
+
+  m_cur = st;
+  return Error("Integer out of range");
+}
+
+
+// Target is not called Handler, which would name Json::Handler here.
+template <typename Target>
+bool Json::Reader::parse(Target &target)
+{
+  Parser<Target> parser(m_cur, m_last);
+  if (!parser.ParseValue(target)) {
+    m_message = parser.ErrorMessage();
+    m_error   = parser.ErrorPosition();
+    return false;
+  }
+
+  m_cur = parser.Position();
+  return true;
+}
@@ -0,0 +1,95 @@
+#ifndef SOURCE_READER_HPP
+#define SOURCE_READER_HPP
+
+
+#include "json.hpp"
+
+#include <limits>
+#include <string>
+#include <string_view>
+
+
+// Pull parser: the caller asks for the value it expects next, and a value
+// of another type is an error. Lists and structs are walked with
+// NextElement/NextMember, which return false at the closing bracket:
+//
+//   reader.StartStruct();
+//   for (std::string_view key; reader.NextMember(key);)
+//     key == "id" ? reader.ReadInt(id) : reader.Skip();
+//   if (reader.Failed())
+//     fail(reader.GetLog());
+//
+// After the first error every call returns false. Strings and keys are
+// only valid until the next call. Lists and structs opened with
+// StartList/StartStruct count towards Json::MaxDepth.
+class Json::Reader
+{
+public:
+
+  explicit Reader(std::string_view json);
+
+  Reader(const Reader &reader)            = delete;
+  Reader& operator=(const Reader &reader) = delete;
+
+  // Consumes a null and returns true if one comes next; otherwise leaves
+  // the input as it is.
+  bool ReadNull  ();
+  bool ReadBool  (bool             &out);
+  // Integers outside [min, max] are errors reported at their first digit.
+  bool ReadInt   (int64_t          &out,
+                  int64_t           min = std::numeric_limits<int64_t>::min(),
+                  int64_t           max = std::numeric_limits<int64_t>::max());
+  // Also takes integers above INT64_MAX, which the parser reads as floats.
+  bool ReadUInt  (uint64_t         &out,
+                  uint64_t          max = std::numeric_limits<uint64_t>::max());
+  // Accepts integers too. Numbers whose magnitude passes max are errors
+  // reported at their first character.
+  bool ReadFloat (double           &out,
+                  double            max = std::numeric_limits<double>::infinity());
+  bool ReadString(std::string_view &out);
+  bool ReadValue (Value            &out);
+
+  bool StartList  ();
+  bool NextElement();
+  bool StartStruct();
+  bool NextMember (std::string_view &key);
+
+  // Skips the next value, checking its syntax.
+  bool Skip  ();
+  // Checks that nothing but whitespace is left.
+  bool Finish();
+
+  // Records an error at the current position and returns false.
+  bool Error(const char *msg);
+
+  bool        Failed() const { return m_message != nullptr; }
+  std::string GetLog() const;
+
+private:
+
+  class Sink;
+
+  const char  *m_first;
+  const char  *m_cur;
+  const char  *m_last;
+  const char  *m_message;
+  const char  *m_error;
+  // Just after StartList/StartStruct, before the first element.
+  bool         m_fresh;
+  size_t       m_depth;
+  std::string  m_scratch;
+
+
+  bool peek(char &ch);
+  bool expect(char ch, const char *msg);
+  bool next(char close);
+  bool scalar(Sink &sink, ValueType type, const char *msg);
+  bool range (const char *st, bool fits);
+
+  template <typename Target>
+  bool parse(Target &target);
+
+};
+
+
+#endif // !SOURCE_READER_HPP
@@ -0,0 +1,128 @@
+#include "scanner.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define JSON_SCANNER_X86
+#endif
+
+
+static bool is_ws(char ch)
+{
+  return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+
+const Json::Scanner::Kernels& Json::Scanner::kernels()
+{
+  static const Kernels kernels = []() -> Kernels
+  {
+#ifdef JSON_SCANNER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      return { find_quote_avx2, skip_ws_avx2 };
+    if (__builtin_cpu_supports("sse4.2"))
+      return { find_quote_sse42, skip_ws_sse42 };
+#endif
+    return { find_quote_scalar, skip_ws_scalar };
+  }();
+
+  return kernels;
+}
+
+
+const char* Json::Scanner::find_quote_scalar(const char *first, const char *last)
+{
+  while (first != last && *first != '\"' && *first != '\\')
+    ++first;
+  return first;
+}
+
+const char* Json::Scanner::skip_ws_scalar(const char *first, const char *last)
+{
+  while (first != last && is_ws(*first))
+    ++first;
+  return first;
+}
+
+#ifdef JSON_SCANNER_X86
+
+// Whitespace is matched with one byte shuffle indexed by the low nibble;
+// every other slot of the table holds a byte whose low nibble differs from
+// its index, so it can never compare equal.
+
+__attribute__((target("sse4.2")))
+const char* Json::Scanner::find_quote_sse42(const char *first, const char *last)
+{
+  const __m128i quote     = _mm_set1_epi8('\"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+
+  for (; last - first >= 16; first += 16) {
+    __m128i  v    = _mm_loadu_si128((const __m128i*)first);
+    unsigned mask = (unsigned)_mm_movemask_epi8(
+      _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash))
+    );
+    if (mask)
+      return first + __builtin_ctz(mask);
+  }
+
+  return find_quote_scalar(first, last);
+}
+
+__attribute__((target("sse4.2")))
+const char* Json::Scanner::skip_ws_sse42(const char *first, const char *last)
+{
+  const __m128i table = _mm_setr_epi8(
+    ' ', 100, 100, 100, 17, 100, 113, 2, 100, '\t', '\n', 112, 100, '\r', 100, 100
+  );
+
+  for (; last - first >= 16; first += 16) {
+    __m128i  v    = _mm_loadu_si128((const __m128i*)first);
+    unsigned mask = (unsigned)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(_mm_shuffle_epi8(table, v), v)
+    ) ^ 0xFFFF;
+    if (mask)
+      return first + __builtin_ctz(mask);
+  }
+
+  return skip_ws_scalar(first, last);
+}
+
+__attribute__((target("avx2")))
+const char* Json::Scanner::find_quote_avx2(const char *first, const char *last)
+{
+  const __m256i quote     = _mm256_set1_epi8('\"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+
+  for (; last - first >= 32; first += 32) {
+    __m256i  v    = _mm256_loadu_si256((const __m256i*)first);
+    unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(
+      _mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)
+    ));
+    if (mask)
+      return first + __builtin_ctz(mask);
+  }
+
+  return find_quote_scalar(first, last);
+}
+
+__attribute__((target("avx2")))
+const char* Json::Scanner::skip_ws_avx2(const char *first, const char *last)
+{
+  const __m256i table = _mm256_setr_epi8(
+    ' ', 100, 100, 100, 17, 100, 113, 2, 100, '\t', '\n', 112, 100, '\r', 100, 100,
+    ' ', 100, 100, 100, 17, 100, 113, 2, 100, '\t', '\n', 112, 100, '\r', 100, 100
+  );
+
+  for (; last - first >= 32; first += 32) {
+    __m256i  v    = _mm256_loadu_si256((const __m256i*)first);
+    unsigned mask = ~(unsigned)_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(_mm256_shuffle_epi8(table, v), v)
+    );
+    if (mask)
+      return first + __builtin_ctz(mask);
+  }
+
+  return skip_ws_scalar(first, last);
+}
+
+#endif
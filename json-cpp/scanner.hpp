@@ -0,0 +1,66 @@
+#ifndef SOURCE_SCANNER_HPP
+#define SOURCE_SCANNER_HPP
+
+
+#include "json.hpp"
+
+
+// Vectorized scans behind the parser's inner loops. Short runs are checked
+// inline; longer ones go to an AVX2 or SSE4.2 kernel picked once from the
+// CPU features, or to a plain loop elsewhere.
+class Json::Scanner
+{
+public:
+
+  static constexpr size_t InlineSize = 16;
+
+  // First '"' or '\' in [first, last), or last.
+  static const char* FindQuote(const char *first, const char *last)
+  {
+    for (size_t i = 0; i < InlineSize; ++i, ++first)
+      if (first == last || *first == '\"' || *first == '\\')
+        return first;
+
+    return kernels().find_quote(first, last);
+  }
+
+  // First byte in [first, last) that is not JSON whitespace, or last.
+  static const char* SkipWhitespace(const char *first, const char *last)
+  {
+    for (size_t i = 0; i < InlineSize; ++i, ++first)
+      if (
+        first == last ||
+        (*first != ' ' && *first != '\t' && *first != '\r' && *first != '\n')
+      ) {
+        return first;
+      }
+
+    return kernels().skip_ws(first, last);
+  }
+
+private:
+
+  typedef const char* (*Scan)(const char *first, const char *last);
+
+  struct Kernels
+  {
+    Scan find_quote;
+    Scan skip_ws;
+  };
+
+
+  static const Kernels& kernels();
+
+  static const char* find_quote_scalar(const char *first, const char *last);
+  static const char* skip_ws_scalar   (const char *first, const char *last);
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  static const char* find_quote_sse42 (const char *first, const char *last);
+  static const char* skip_ws_sse42    (const char *first, const char *last);
+  static const char* find_quote_avx2  (const char *first, const char *last);
+  static const char* skip_ws_avx2     (const char *first, const char *last);
+#endif
+
+};
+
+
+#endif // !SOURCE_SCANNER_HPP
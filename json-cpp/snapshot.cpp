@@ -0,0 +1,518 @@
+#include "snapshot.hpp"
+#include "property.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+
+static constexpr char     Magic[4]  = { 'J', 'S', 'N', 'P' };
+static constexpr uint32_t ByteOrder = 0x01020304;
+static constexpr uint32_t Version   = 1;
+
+
+// Scalars and strings of up to 8 bytes are held in the slot; longer
+// strings, lists and structs point to a record by its offset from the
+// start of the image. Records are 8-byte aligned:
+//
+//   string  u64 size, size bytes, '\0'
+//   list    u64 count, Slot[count]
+//   struct  u64 count, u64 slots, Member[count], u64[slots]
+//
+// The u64 slots of a struct are an open-addressing table holding the
+// upper half of the name's hash and the member's index + 1, or 0 when
+// empty; structs with fewer than MinIndexed members have none.
+struct Json::Snapshot::Slot
+{
+  uint32_t type;
+  // Length + 1 of a string held in data, otherwise 0.
+  uint32_t small;
+  uint64_t data;
+};
+
+struct Json::Snapshot::Member
+{
+  uint64_t name;
+  Slot     value;
+};
+
+struct Json::Snapshot::Header
+{
+  char     magic[4];
+  uint32_t order;
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t size;
+  Slot     root;
+};
+
+
+class Json::Snapshot::Builder
+{
+public:
+
+  std::string Build(const Value &val)
+  {
+    m_out.assign(sizeof(Header), '\0');
+
+    Header header = {};
+    header.root = put_value(val);
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.order   = ByteOrder;
+    header.version = Version;
+    header.size    = m_out.size();
+    std::memcpy(m_out.data(), &header, sizeof(header));
+
+    return std::move(m_out);
+  }
+
+private:
+
+  std::string                                    m_out;
+  // Names are written once; the views point into the source value.
+  std::unordered_map<std::string_view, uint64_t> m_names;
+
+
+  uint64_t alloc(size_t size)
+  {
+    uint64_t off = m_out.size();
+    m_out.resize(off + ((size + 7) & ~(size_t)7));
+    return off;
+  }
+
+  template <typename T>
+  void store(uint64_t off, const T &val)
+  {
+    std::memcpy(m_out.data() + off, &val, sizeof(T));
+  }
+
+  uint64_t put_string(std::string_view str)
+  {
+    uint64_t off = alloc(sizeof(uint64_t) + str.size() + 1);
+    store<uint64_t>(off, str.size());
+    std::memcpy(m_out.data() + off + sizeof(uint64_t), str.data(), str.size());
+    return off;
+  }
+
+  uint64_t put_name(std::string_view name)
+  {
+    auto it = m_names.find(name);
+    if (it != m_names.end())
+      return it->second;
+
+    uint64_t off = put_string(name);
+    m_names.emplace(name, off);
+    return off;
+  }
+
+  Slot put_value(const Value &val)
+  {
+    Slot slot = { (uint32_t)val.GetType(), 0, 0 };
+
+    switch (val.GetType())
+    {
+    case Bool:
+      slot.data = val.GetBool();
+      break;
+    case Int: {
+      int64_t num = val.GetInt();
+      std::memcpy(&slot.data, &num, sizeof(num));
+      break;
+    }
+    case Float: {
+      double num = val.GetFloat();
+      std::memcpy(&slot.data, &num, sizeof(num));
+      break;
+    }
+    case String: {
+      std::string_view str = val.GetStringView();
+      if (str.size() <= sizeof(slot.data)) {
+        slot.small = (uint32_t)str.size() + 1;
+        std::memcpy(&slot.data, str.data(), str.size());
+      }
+      else {
+        slot.data = put_string(str);
+      }
+      break;
+    }
+    case List: {
+      const ListType &list = val.GetListRef();
+
+      uint64_t off = alloc(sizeof(uint64_t) + list.size() * sizeof(Slot));
+      store<uint64_t>(off, list.size());
+      for (size_t i = 0; i < list.size(); ++i) {
+        Slot item = put_value(list[i]);
+        store(off + sizeof(uint64_t) + i * sizeof(Slot), item);
+      }
+      slot.data = off;
+      break;
+    }
+    case Struct:
+      slot.data = put_struct(val.GetStructRef());
+      break;
+    default:
+      break;
+    }
+
+    return slot;
+  }
+
+  uint64_t put_struct(const StructType &props)
+  {
+    size_t slots = 0;
+    if (props.size() >= MinIndexed) {
+      slots = 32;
+      while (slots < props.size() * 2)
+        slots <<= 1;
+    }
+
+    uint64_t off = alloc(
+      2 * sizeof(uint64_t) + props.size() * sizeof(Member) +
+      slots * sizeof(uint64_t)
+    );
+    uint64_t members = off + 2 * sizeof(uint64_t);
+    uint64_t table   = members + props.size() * sizeof(Member);
+
+    store<uint64_t>(off, props.size());
+    store<uint64_t>(off + sizeof(uint64_t), slots);
+
+    for (size_t i = 0; i < props.size(); ++i) {
+      std::string_view name = props[i].GetNameView();
+
+      Member member;
+      member.name  = put_name(name);
+      member.value = put_value(props[i].GetValue());
+      store(members + i * sizeof(Member), member);
+
+      if (slots)
+        place(table, slots, members, i, name);
+    }
+
+    return off;
+  }
+
+  // Duplicate names keep the first member, as in a Value.
+  void place(uint64_t table, size_t slots, uint64_t members, size_t i, std::string_view name)
+  {
+    uint64_t h   = hash(name);
+    uint32_t tag = (uint32_t)(h >> 32);
+
+    for (size_t pos = h & (slots - 1);; pos = (pos + 1) & (slots - 1)) {
+      uint64_t entry;
+      std::memcpy(&entry, m_out.data() + table + pos * sizeof(uint64_t), sizeof(entry));
+
+      if (entry == 0) {
+        store<uint64_t>(table + pos * sizeof(uint64_t), ((uint64_t)tag << 32) | (i + 1));
+        return;
+      }
+
+      size_t j = (size_t)(uint32_t)entry - 1;
+      Member other;
+      std::memcpy(&other, m_out.data() + members + j * sizeof(Member), sizeof(other));
+
+      uint64_t size;
+      std::memcpy(&size, m_out.data() + other.name, sizeof(size));
+      if (
+        (uint32_t)(entry >> 32) == tag && size == name.size() &&
+        std::memcmp(m_out.data() + other.name + sizeof(uint64_t), name.data(), size) == 0
+      ) {
+        return;
+      }
+    }
+  }
+
+};
+
+
+Json::Snapshot::Snapshot()
+{}
+
+
+std::string Json::Snapshot::Build(const Value &val)
+{
+  return Builder().Build(val);
+}
+
+bool Json::Snapshot::Write(const Value &val, const std::filesystem::path &path)
+{
+  std::string image = Build(val);
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return false;
+
+  file.write(image.data(), image.size());
+  file.close();
+  return !file.fail();
+}
+
+
+Json::ERR Json::Snapshot::Open(const std::filesystem::path &path)
+{
+  if (!m_file.Open(path))
+    return ERR::BAD_PATH;
+
+  return load(m_file.GetData());
+}
+
+Json::ERR Json::Snapshot::Load(std::string_view data)
+{
+  return load(data);
+}
+
+
+Json::Snapshot::View Json::Snapshot::GetData() const
+{
+  if (m_data.empty())
+    throw Value::NotFound;
+
+  return View(m_data.data(), &((const Header*)m_data.data())->root, nullptr);
+}
+
+
+Json::ERR Json::Snapshot::load(std::string_view data)
+{
+  if (data.data() != m_file.GetData().data())
+    m_file.Close();
+
+  m_data = std::string_view();
+
+  const Header *header = (const Header*)data.data();
+  if (
+    data.size() < sizeof(Header) || (uintptr_t)data.data() % alignof(Header) != 0 ||
+    std::memcmp(header->magic, Magic, sizeof(Magic)) != 0 ||
+    header->order != ByteOrder || header->version != Version ||
+    header->size != data.size()
+  ) {
+    return ERR::BAD_JSON;
+  }
+
+  m_data = data;
+  return ERR::SUCCESS;
+}
+
+
+// 64-bit FNV-1a; part of the format, so it must not change.
+uint64_t Json::Snapshot::hash(std::string_view name)
+{
+  uint64_t h = 0xCBF29CE484222325;
+  for (char ch : name) {
+    h ^= (uint8_t)ch;
+    h *= 0x100000001B3;
+  }
+  return h;
+}
+
+
+Json::ValueType Json::Snapshot::View::GetType() const
+{
+  return (ValueType)m_slot->type;
+}
+
+bool Json::Snapshot::View::GetBool() const
+{
+  if (m_slot->type != Bool)
+    throw Value::WrongType;
+
+  return m_slot->data != 0;
+}
+
+int64_t Json::Snapshot::View::GetInt() const
+{
+  if (m_slot->type != Int)
+    throw Value::WrongType;
+
+  int64_t val;
+  std::memcpy(&val, &m_slot->data, sizeof(val));
+  return val;
+}
+
+double Json::Snapshot::View::GetFloat() const
+{
+  if (m_slot->type != Float)
+    throw Value::WrongType;
+
+  double val;
+  std::memcpy(&val, &m_slot->data, sizeof(val));
+  return val;
+}
+
+std::string_view Json::Snapshot::View::GetStringView() const
+{
+  if (m_slot->type == String && m_slot->small)
+    return std::string_view((const char*)&m_slot->data, m_slot->small - 1);
+
+  const char *rec = record(String);
+  return std::string_view(rec + sizeof(uint64_t), *(const uint64_t*)rec);
+}
+
+
+std::string_view Json::Snapshot::View::GetNameView() const
+{
+  if (!m_member)
+    return std::string_view();
+
+  const char *rec = m_base + m_member->name;
+  return std::string_view(rec + sizeof(uint64_t), *(const uint64_t*)rec);
+}
+
+
+size_t Json::Snapshot::View::Size() const
+{
+  if (m_slot->type != List && m_slot->type != Struct)
+    throw Value::WrongType;
+
+  return (size_t)*(const uint64_t*)(m_base + m_slot->data);
+}
+
+bool Json::Snapshot::View::Contains(std::string_view prop_name) const
+{
+  return find(prop_name) != nullptr;
+}
+
+bool Json::Snapshot::View::Contains(const std::wstring &prop_name) const
+{
+  return Contains(Json::to_str(prop_name));
+}
+
+
+Json::Snapshot::View Json::Snapshot::View::operator[](std::string_view prop_name) const
+{
+  const Member *member = find(prop_name);
+  if (!member)
+    throw Value::NotFound;
+
+  return View(m_base, &member->value, member);
+}
+
+Json::Snapshot::View Json::Snapshot::View::operator[](const std::wstring &prop_name) const
+{
+  return (*this)[Json::to_str(prop_name)];
+}
+
+Json::Snapshot::View Json::Snapshot::View::operator[](size_t i) const
+{
+  const char *rec = record(List);
+  if (i >= *(const uint64_t*)rec)
+    throw Value::NotFound;
+
+  const Slot *items = (const Slot*)(rec + sizeof(uint64_t));
+  return View(m_base, &items[i], nullptr);
+}
+
+
+Json::Snapshot::Iterator Json::Snapshot::View::begin() const
+{
+  if (m_slot->type == List)
+    return Iterator(m_base, m_base + m_slot->data + sizeof(uint64_t), false);
+  if (m_slot->type == Struct)
+    return Iterator(m_base, m_base + m_slot->data + 2 * sizeof(uint64_t), true);
+
+  throw Value::WrongType;
+}
+
+Json::Snapshot::Iterator Json::Snapshot::View::end() const
+{
+  Iterator it = begin();
+  it.m_pos += Size() * it.m_stride;
+  return it;
+}
+
+
+Json::Value Json::Snapshot::View::ToValue() const
+{
+  switch (m_slot->type)
+  {
+  case Bool:
+    return Value(GetBool());
+  case Int:
+    return Value(GetInt());
+  case Float:
+    return Value(GetFloat());
+  case String:
+    return Value(StringType(GetStringView()));
+  case List: {
+    ListType list;
+    list.reserve(Size());
+    for (View item : *this)
+      list.push_back(item.ToValue());
+    return Value(std::move(list));
+  }
+  case Struct: {
+    StructType props;
+    props.reserve(Size());
+    for (View item : *this)
+      props.emplace_back(item.GetName(), item.ToValue());
+    return Value(std::move(props));
+  }
+  default:
+    return Value();
+  }
+}
+
+
+const char* Json::Snapshot::View::record(ValueType type) const
+{
+  if (m_slot->type != (uint32_t)type) {
+    if (type == List)
+      throw Value::NotList;
+    if (type == Struct)
+      throw Value::NotStruct;
+    throw Value::WrongType;
+  }
+
+  return m_base + m_slot->data;
+}
+
+const Json::Snapshot::Member* Json::Snapshot::View::find(std::string_view name) const
+{
+  const char     *rec     = record(Struct);
+  uint64_t        count   = ((const uint64_t*)rec)[0];
+  uint64_t        slots   = ((const uint64_t*)rec)[1];
+  const Member   *members = (const Member*)(rec + 2 * sizeof(uint64_t));
+  const uint64_t *table   = (const uint64_t*)(members + count);
+
+  const auto same_name = [&](const Member &member)
+  {
+    const char *str = m_base + member.name;
+    return
+      *(const uint64_t*)str == name.size() &&
+      std::memcmp(str + sizeof(uint64_t), name.data(), name.size()) == 0;
+  };
+
+  if (slots == 0) {
+    for (uint64_t i = 0; i < count; ++i)
+      if (same_name(members[i]))
+        return &members[i];
+    return nullptr;
+  }
+
+  uint64_t h   = hash(name);
+  uint32_t tag = (uint32_t)(h >> 32);
+
+  for (uint64_t pos = h & (slots - 1);; pos = (pos + 1) & (slots - 1)) {
+    uint64_t entry = table[pos];
+    if (entry == 0)
+      return nullptr;
+
+    const Member &member = members[(uint32_t)entry - 1];
+    if ((uint32_t)(entry >> 32) == tag && same_name(member))
+      return &member;
+  }
+}
+
+
+Json::Snapshot::Iterator::Iterator(const char *base, const char *pos, bool is_struct) :
+  m_base(base), m_pos(pos),
+  m_stride(is_struct ? sizeof(Member) : sizeof(Slot)), m_struct(is_struct)
+{}
+
+Json::Snapshot::View Json::Snapshot::Iterator::operator*() const
+{
+  if (m_struct) {
+    const Member *member = (const Member*)m_pos;
+    return View(m_base, &member->value, member);
+  }
+
+  return View(m_base, (const Slot*)m_pos, nullptr);
+}
@@ -0,0 +1,151 @@
+#ifndef SOURCE_SNAPSHOT_HPP
+#define SOURCE_SNAPSHOT_HPP
+
+
+#include "json.hpp"
+#include "value.hpp"
+#include "mapped_file.hpp"
+
+#include <string>
+#include <string_view>
+
+
+// Flat, pointer-free image of a document that is read in place. Values
+// are fixed-size slots holding scalars and short strings; longer strings,
+// lists and structs live at offsets from the start of the image, structs
+// with MinIndexed or more members carry a hash table of their names, and
+// property names are stored once. A
+// snapshot is written once:
+//
+//   Json::Snapshot::Write(json.GetData(), "reference.snap");
+//
+// and opened by mapping the file, which does not depend on its size, so
+// processes opening the same file share it in the page cache:
+//
+//   Json::Snapshot snap;
+//   snap.Open("reference.snap");
+//   int64_t id = snap.GetData()["user"]["id"].GetInt();
+//
+// Only the header is checked on open; the contents are trusted to come
+// from Build or Write on a machine of the same byte order.
+class Json::Snapshot
+{
+public:
+
+  class View;
+  class Iterator;
+
+  static constexpr size_t MinIndexed = 16;
+
+  Snapshot();
+
+  Snapshot(const Snapshot &snap)            = delete;
+  Snapshot& operator=(const Snapshot &snap) = delete;
+
+  static std::string Build(const Value &val);
+  static bool        Write(const Value &val, const std::filesystem::path &path);
+
+  // ERR::BAD_JSON when the data is not a snapshot. Load reads data in
+  // place: it must stay alive and be 8-byte aligned.
+  ERR Open(const std::filesystem::path &path);
+  ERR Load(std::string_view data);
+
+  View GetData() const;
+
+private:
+
+  class Builder;
+
+  struct Header;
+  struct Slot;
+  struct Member;
+
+  MappedFile       m_file;
+  std::string_view m_data;
+
+
+  ERR load(std::string_view data);
+
+  static uint64_t hash(std::string_view name);
+
+};
+
+
+class Json::Snapshot::View
+{
+public:
+
+  ValueType GetType() const;
+
+  bool             GetBool      () const;
+  int64_t          GetInt       () const;
+  double           GetFloat     () const;
+  std::string      GetString    () const { return std::string(GetStringView()); }
+  std::string_view GetStringView() const;
+  std::wstring     GetStringW   () const { return Json::to_wstr(GetStringView()); }
+
+  // Name of the struct member the view was reached through, or "".
+  std::string_view GetNameView() const;
+  std::string      GetName    () const { return std::string(GetNameView()); }
+
+  size_t Size    ()                              const;
+  bool   Contains(std::string_view    prop_name) const;
+  bool   Contains(const std::wstring &prop_name) const;
+
+  View operator[](std::string_view    prop_name) const;
+  View operator[](const std::wstring &prop_name) const;
+  View operator[](size_t              i)         const;
+
+  // Elements of a list or member values of a struct, in document order.
+  Iterator begin() const;
+  Iterator end  () const;
+
+  Value ToValue() const;
+
+private:
+
+  const char   *m_base;
+  const Slot   *m_slot;
+  const Member *m_member;
+
+
+  View(const char *base, const Slot *slot, const Member *member) :
+    m_base(base), m_slot(slot), m_member(member)
+  {}
+
+  const char*   record(ValueType type) const;
+  const Member* find  (std::string_view name) const;
+
+  friend class Json::Snapshot;
+  friend class Json::Snapshot::Iterator;
+
+};
+
+
+class Json::Snapshot::Iterator
+{
+public:
+
+  View operator*() const;
+
+  Iterator& operator++() { m_pos += m_stride; return *this; }
+
+  bool operator==(const Iterator &it) const { return m_pos == it.m_pos; }
+  bool operator!=(const Iterator &it) const { return m_pos != it.m_pos; }
+
+private:
+
+  const char *m_base;
+  const char *m_pos;
+  size_t      m_stride;
+  bool        m_struct;
+
+
+  Iterator(const char *base, const char *pos, bool is_struct);
+
+  friend class Json::Snapshot::View;
+
+};
+
+
+#endif // !SOURCE_SNAPSHOT_HPP
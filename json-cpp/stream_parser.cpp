@@ -0,0 +1,622 @@
+#include "stream_parser.hpp"
+#include "dom_builder.hpp"
+#include "scanner.hpp"
+#include "number.hpp"
+
+
+static bool is_ws(char ch)
+{
+  return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+static bool is_digit(char ch)
+{
+  return ch >= '0' && ch <= '9';
+}
+
+static int hex_digit(char ch)
+{
+  if (ch >= '0' && ch <= '9') return ch - '0';
+  if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+  if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+  return -1;
+}
+
+
+Json::StreamParser::StreamParser() :
+  m_target(nullptr),
+  m_cur(nullptr), m_last(nullptr), m_run(nullptr), m_mark(nullptr)
+{
+  Reset();
+}
+
+Json::StreamParser::StreamParser(Handler &handler) :
+  m_target(&handler),
+  m_cur(nullptr), m_last(nullptr), m_run(nullptr), m_mark(nullptr)
+{
+  Reset();
+}
+
+Json::StreamParser::~StreamParser()
+{}
+
+
+Json::ERR Json::StreamParser::Feed(const char *data, size_t size)
+{
+  if (m_state == FAILED)
+    return m_err;
+
+  m_cur  = data;
+  m_last = data + size;
+  m_run  = data;
+  m_mark = data;
+
+  if (!run())
+    return fail();
+
+  if (m_state == STRING)
+    m_token.append(m_run, m_last);
+  position(m_last);
+  return ERR::SUCCESS;
+}
+
+Json::ERR Json::StreamParser::Finish()
+{
+  if (m_state == FAILED)
+    return m_err;
+
+  m_cur = m_last = m_run = m_mark = nullptr;
+
+  if (m_state == NUMBER) {
+    if (m_part == EXPONENT_START || m_part == EXPONENT_SIGN) {
+      error("Unknown type", m_token_pos);
+      return fail();
+    }
+    if (!end_number())
+      return fail();
+  }
+
+  switch (m_state)
+  {
+  case DOC:
+    if (m_documents != 0)
+      return ERR::SUCCESS;
+    m_log = "Empty json";
+    m_err = ERR::BAD_JSON;
+    break;
+  case VALUE:
+  case LIST_FIRST:
+    error("Expected value", m_pos);
+    break;
+  case LIST_NEXT:
+    error("Expected ']'", m_pos);
+    break;
+  case STRUCT_FIRST:
+  case STRUCT_KEY:
+    error("Expected property", m_pos);
+    break;
+  case COLON:
+    error("Expected \':\'", m_pos);
+    break;
+  case STRUCT_NEXT:
+    error("Expected '}'", m_pos);
+    break;
+  case UNICODE:
+    error("Invalid escape sequence", m_token_pos);
+    break;
+  case LITERAL:
+    error("Unknown type", m_token_pos);
+    break;
+  default:
+    error("Expected \'\"\'", m_pos);
+    break;
+  }
+
+  return fail();
+}
+
+void Json::StreamParser::Reset()
+{
+  m_handler   = m_target;
+  m_ready     = 0;
+  m_documents = 0;
+  m_state     = DOC;
+  m_err       = ERR::SUCCESS;
+  m_pos       = { 1, 1 };
+  m_token_pos = { 1, 1 };
+  m_high      = 0;
+
+  m_builder.reset();
+  m_docs.clear();
+  m_log.clear();
+  m_stack.clear();
+  m_token.clear();
+}
+
+
+Json::Value Json::StreamParser::PopDocument()
+{
+  if (m_ready == 0)
+    throw Value::NotFound;
+
+  Value val(std::move(m_docs.front()));
+  m_docs.pop_front();
+  --m_ready;
+  return val;
+}
+
+
+bool Json::StreamParser::run()
+{
+  while (m_cur != m_last) {
+    if (m_state < STRING && is_ws(*m_cur)) {
+      m_cur = Scanner::SkipWhitespace(m_cur, m_last);
+      if (m_cur == m_last)
+        return true;
+    }
+
+    switch (m_state)
+    {
+    case DOC:
+      if (
+        m_documents != 0 && (*m_cur == ',' || *m_cur == ']' || *m_cur == '}')
+      ) {
+        return error("Unknown type", m_cur);
+      }
+      start_document();
+      m_state = VALUE;
+      break;
+
+    case VALUE:
+      if (!start_value())
+        return false;
+      break;
+
+    case LIST_FIRST:
+      if (*m_cur == ']') {
+        if (!end_container())
+          return false;
+      }
+      else {
+        m_state = VALUE;
+      }
+      break;
+
+    case LIST_NEXT:
+      if (*m_cur == ',') {
+        ++m_cur;
+        m_state = VALUE;
+      }
+      else if (*m_cur == ']') {
+        if (!end_container())
+          return false;
+      }
+      else {
+        return error("Expected ']'", m_cur);
+      }
+      break;
+
+    case STRUCT_FIRST:
+      if (*m_cur == '}') {
+        if (!end_container())
+          return false;
+      }
+      else {
+        m_state = STRUCT_KEY;
+      }
+      break;
+
+    case STRUCT_KEY:
+      if (*m_cur == '}')
+        return error("Expected property", m_cur);
+      if (*m_cur != '\"')
+        return error("Expected \'\"\'", m_cur);
+
+      m_key = true;
+      m_run = ++m_cur;
+      m_token.clear();
+      m_state = STRING;
+      break;
+
+    case COLON:
+      if (*m_cur != ':')
+        return error("Expected \':\'", m_cur);
+      ++m_cur;
+      m_state = VALUE;
+      break;
+
+    case STRUCT_NEXT:
+      if (*m_cur == ',') {
+        ++m_cur;
+        m_state = STRUCT_KEY;
+      }
+      else if (*m_cur == '}') {
+        if (!end_container())
+          return false;
+      }
+      else {
+        return error("Expected '}'", m_cur);
+      }
+      break;
+
+    case STRING:
+      m_cur = Scanner::FindQuote(m_cur, m_last);
+      if (m_cur == m_last)
+        return true;
+
+      if (*m_cur == '\"') {
+        if (!end_string())
+          return false;
+        break;
+      }
+
+      m_token_pos = position(m_cur);
+      m_token.append(m_run, m_cur);
+      ++m_cur;
+      m_state = ESCAPE;
+      break;
+
+    case ESCAPE: {
+      char ch;
+      switch (*m_cur)
+      {
+      case '\"': ch = '\"'; break;
+      case '\\': ch = '\\'; break;
+      case '/':  ch = '/';  break;
+      case 'b':  ch = '\b'; break;
+      case 'f':  ch = '\f'; break;
+      case 'n':  ch = '\n'; break;
+      case 'r':  ch = '\r'; break;
+      case 't':  ch = '\t'; break;
+      case 'u':
+        ++m_cur;
+        m_cp    = 0;
+        m_hex   = 0;
+        m_state = UNICODE;
+        continue;
+      default:
+        return error("Invalid escape sequence", m_token_pos);
+      }
+
+      m_token.push_back(ch);
+      m_run   = ++m_cur;
+      m_state = STRING;
+      break;
+    }
+
+    case UNICODE:
+      if (!step_unicode(*m_cur))
+        return false;
+      break;
+
+    // A high surrogate waits for a "\u" low surrogate to pair with; any
+    // other continuation leaves it unpaired.
+    case SURROGATE_SLASH:
+      if (*m_cur == '\\') {
+        m_token_pos = position(m_cur);
+        ++m_cur;
+        m_state = SURROGATE_U;
+      }
+      else {
+        append_cp(m_high);
+        m_high  = 0;
+        m_run   = m_cur;
+        m_state = STRING;
+      }
+      break;
+
+    case SURROGATE_U:
+      if (*m_cur == 'u') {
+        ++m_cur;
+        m_cp    = 0;
+        m_hex   = 0;
+        m_state = UNICODE;
+      }
+      else {
+        append_cp(m_high);
+        m_high  = 0;
+        m_state = ESCAPE;
+      }
+      break;
+
+    case NUMBER:
+      if (!step_number(*m_cur))
+        return false;
+      break;
+
+    case LITERAL:
+      if (*m_cur != m_literal[m_literal_i])
+        return error("Unknown type", m_token_pos);
+      ++m_cur;
+
+      if (m_literal[++m_literal_i] == '\0') {
+        bool ok =
+          m_literal[0] == 'n' ? m_handler->Null() :
+          m_handler->Bool(m_literal[0] == 't');
+        if (!ok)
+          return abort();
+        if (!end_value())
+          return false;
+      }
+      break;
+
+    default:
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+void Json::StreamParser::start_document()
+{
+  m_stack.clear();
+
+  if (!m_target) {
+    m_docs.emplace_back();
+    m_builder.reset(new DomBuilder(&m_docs.back()));
+    m_handler = m_builder.get();
+  }
+}
+
+bool Json::StreamParser::start_value()
+{
+  const char ch = *m_cur;
+
+  switch (ch)
+  {
+  case '{':
+  case '[':
+    if (m_stack.size() == MaxDepth)
+      return error("Nesting too deep", m_cur);
+    if (!(ch == '{' ? m_handler->StartStruct() : m_handler->StartList()))
+      return abort();
+    m_stack.push_back({ ch, 0 });
+    ++m_cur;
+    m_state = ch == '{' ? STRUCT_FIRST : LIST_FIRST;
+    return true;
+  case '\"':
+    m_key = false;
+    m_run = ++m_cur;
+    m_token.clear();
+    m_state = STRING;
+    return true;
+  case 't':
+  case 'f':
+  case 'n':
+    m_token_pos = position(m_cur);
+    m_literal   = ch == 't' ? "true" : ch == 'f' ? "false" : "null";
+    m_literal_i = 1;
+    ++m_cur;
+    m_state = LITERAL;
+    return true;
+  case ',':
+  case ']':
+  case '}':
+    return error("Expected value", m_cur);
+  default:
+    if (!is_digit(ch) && ch != '-' && ch != '.')
+      return error("Unknown type", m_cur);
+
+    m_token_pos = position(m_cur);
+    m_token.assign(1, ch);
+    m_part     = ch == '.' ? FRACTION : INTEGER;
+    m_float    = ch == '.';
+    m_negative = ch == '-';
+    m_digits   = is_digit(ch) ? 1 : 0;
+    m_mantissa = is_digit(ch) ? (uint64_t)(ch - '0') : 0;
+    ++m_cur;
+    m_state = NUMBER;
+    return true;
+  }
+}
+
+bool Json::StreamParser::end_value()
+{
+  if (m_stack.empty()) {
+    ++m_documents;
+    if (!m_target) {
+      ++m_ready;
+      m_builder.reset();
+    }
+    m_state = DOC;
+    return true;
+  }
+
+  ++m_stack.back().count;
+  m_state = m_stack.back().type == '[' ? LIST_NEXT : STRUCT_NEXT;
+  return true;
+}
+
+bool Json::StreamParser::end_container()
+{
+  Frame frame = m_stack.back();
+  m_stack.pop_back();
+  ++m_cur;
+
+  bool ok = frame.type == '[' ?
+    m_handler->EndList(frame.count) : m_handler->EndStruct(frame.count);
+  if (!ok)
+    return abort();
+
+  return end_value();
+}
+
+bool Json::StreamParser::end_string()
+{
+  std::string_view str;
+  if (m_token.empty()) {
+    str = std::string_view(m_run, m_cur - m_run);
+  }
+  else {
+    m_token.append(m_run, m_cur);
+    str = m_token;
+  }
+  ++m_cur;
+
+  if (m_key) {
+    if (!m_handler->Key(str))
+      return abort();
+    m_state = COLON;
+    return true;
+  }
+
+  if (!m_handler->String(str))
+    return abort();
+  return end_value();
+}
+
+bool Json::StreamParser::end_number()
+{
+  if (m_digits == 0)
+    return error("Unknown type", m_token_pos);
+
+  const char *first = m_token.data();
+  const char *last  = first + m_token.size();
+  bool        ok;
+
+  if (!m_float && m_digits <= 18) {
+    int64_t val = (int64_t)m_mantissa;
+    ok = m_handler->Int(m_negative ? -val : val);
+  }
+  else {
+    int64_t val;
+    if (!m_float && Number::ParseInt(first, last, val))
+      ok = m_handler->Int(val);
+    else
+      ok = m_handler->Float(Number::ParseFloat(first, last));
+  }
+
+  if (!ok)
+    return abort();
+  return end_value();
+}
+
+// Takes one byte of a number, or ends the number on a byte that cannot
+// continue it. The ending byte is left for the next state.
+bool Json::StreamParser::step_number(char ch)
+{
+  if (is_digit(ch)) {
+    if (m_part == INTEGER) {
+      m_mantissa = m_mantissa * 10 + (uint64_t)(ch - '0');
+      ++m_digits;
+    }
+    else if (m_part == FRACTION) {
+      ++m_digits;
+    }
+    else {
+      m_part = EXPONENT;
+    }
+  }
+  else if (ch == '.' && m_part == INTEGER) {
+    m_part  = FRACTION;
+    m_float = true;
+  }
+  else if ((ch == 'e' || ch == 'E') && m_part <= FRACTION) {
+    if (m_digits == 0)
+      return error("Unknown type", m_token_pos);
+    m_part  = EXPONENT_START;
+    m_float = true;
+  }
+  else if ((ch == '+' || ch == '-') && m_part == EXPONENT_START) {
+    m_part = EXPONENT_SIGN;
+  }
+  else if (m_part == EXPONENT_START || m_part == EXPONENT_SIGN) {
+    return error("Unknown type", m_token_pos);
+  }
+  else {
+    return end_number();
+  }
+
+  m_token.push_back(ch);
+  ++m_cur;
+  return true;
+}
+
+bool Json::StreamParser::step_unicode(char ch)
+{
+  int digit = hex_digit(ch);
+  if (digit < 0)
+    return error("Invalid escape sequence", m_token_pos);
+
+  m_cp = (m_cp << 4) | (uint32_t)digit;
+  ++m_cur;
+  if (++m_hex < 4)
+    return true;
+
+  uint32_t cp = m_cp;
+  if (m_high) {
+    if (cp >= 0xDC00 && cp <= 0xDFFF) {
+      append_cp(0x10000 + ((m_high - 0xD800) << 10) + (cp - 0xDC00));
+      m_high  = 0;
+      m_run   = m_cur;
+      m_state = STRING;
+      return true;
+    }
+
+    append_cp(m_high);
+    m_high = 0;
+  }
+
+  if (cp >= 0xD800 && cp <= 0xDBFF) {
+    m_high  = cp;
+    m_state = SURROGATE_SLASH;
+    return true;
+  }
+
+  append_cp(cp);
+  m_run   = m_cur;
+  m_state = STRING;
+  return true;
+}
+
+
+void Json::StreamParser::append_cp(uint32_t cp)
+{
+  char buf[4];
+  m_token.append(buf, Json::encode_utf8(cp, buf));
+}
+
+Json::StreamParser::Position Json::StreamParser::position(const char *pos)
+{
+  for (; m_mark != pos; ++m_mark) {
+    switch (*m_mark)
+    {
+    case '\r': m_pos.col = 1;                break;
+    case '\n': m_pos.col = 1;  ++m_pos.ln;   break;
+    default:
+      if (((uint8_t)*m_mark & 0xC0) != 0x80)
+        ++m_pos.col;
+      break;
+    }
+  }
+
+  return m_pos;
+}
+
+
+bool Json::StreamParser::error(const char *msg, Position pos)
+{
+  m_log = Json::make_log(msg, pos.ln, pos.col);
+  m_err = ERR::BAD_JSON;
+  return false;
+}
+
+bool Json::StreamParser::abort()
+{
+  m_err = ERR::ABORTED;
+  return false;
+}
+
+Json::ERR Json::StreamParser::fail()
+{
+  m_state = FAILED;
+  m_stack.clear();
+  m_builder.reset();
+
+  if (!m_target && m_docs.size() > m_ready)
+    m_docs.pop_back();
+
+  return m_err;
+}
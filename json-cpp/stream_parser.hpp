@@ -0,0 +1,152 @@
+#ifndef SOURCE_STREAM_PARSER_HPP
+#define SOURCE_STREAM_PARSER_HPP
+
+
+#include "json.hpp"
+#include "value.hpp"
+#include "property.hpp"
+
+#include <deque>
+#include <memory>
+#include <string_view>
+
+
+// Incremental parser fed with input in chunks of any size. All state,
+// including a half-read string, number or escape, is kept between calls
+// to Feed(), so chunks may be split anywhere:
+//
+//   Json::StreamParser parser;
+//   while (size_t size = read(sock, buf, sizeof(buf)))
+//     if (parser.Feed(buf, size) != Json::ERR::SUCCESS)
+//       fail(parser.GetLog());
+//   parser.Finish();
+//   while (parser.HasDocument())
+//     handle(parser.PopDocument());
+//
+// The input may hold several documents one after another. Without a
+// handler each one is built into a Value and queued; with a handler the
+// events are forwarded as they are parsed. A number ending the input is
+// only reported by Finish(). After an error every call fails until
+// Reset().
+class Json::StreamParser
+{
+public:
+
+  StreamParser();
+  explicit StreamParser(Handler &handler);
+  ~StreamParser();
+
+  StreamParser(const StreamParser &parser)            = delete;
+  StreamParser& operator=(const StreamParser &parser) = delete;
+
+  ERR Feed  (const char *data, size_t size);
+  ERR Feed  (std::string_view data) { return Feed(data.data(), data.size()); }
+  ERR Finish();
+  void Reset();
+
+  bool   InDocument      () const { return m_state != DOC; }
+  size_t GetDocumentCount() const { return m_documents;     }
+  bool   HasDocument     () const { return m_ready != 0;    }
+  Value  PopDocument     ();
+
+  const std::string& GetLog() const { return m_log; }
+
+private:
+
+  enum State
+  {
+    DOC,
+    VALUE,
+    LIST_FIRST,
+    LIST_NEXT,
+    STRUCT_FIRST,
+    STRUCT_KEY,
+    COLON,
+    STRUCT_NEXT,
+    STRING,
+    ESCAPE,
+    UNICODE,
+    SURROGATE_SLASH,
+    SURROGATE_U,
+    NUMBER,
+    LITERAL,
+    FAILED
+  };
+
+  enum NumberPart
+  {
+    INTEGER,
+    FRACTION,
+    EXPONENT_START,
+    EXPONENT_SIGN,
+    EXPONENT
+  };
+
+  struct Frame
+  {
+    char   type;
+    size_t count;
+  };
+
+  struct Position
+  {
+    uint64_t ln;
+    uint64_t col;
+  };
+
+  Handler                     *m_target;
+  Handler                     *m_handler;
+  std::unique_ptr<DomBuilder>  m_builder;
+  std::deque<Value>            m_docs;
+  size_t                       m_ready;
+  size_t                       m_documents;
+
+  State              m_state;
+  ERR                m_err;
+  std::string        m_log;
+  std::vector<Frame> m_stack;
+
+  const char *m_cur;
+  const char *m_last;
+  const char *m_run;
+  const char *m_mark;
+  Position    m_pos;
+  Position    m_token_pos;
+
+  std::string  m_token;
+  bool         m_key;
+  uint32_t     m_cp;
+  uint32_t     m_high;
+  int          m_hex;
+  NumberPart   m_part;
+  bool         m_negative;
+  bool         m_float;
+  size_t       m_digits;
+  uint64_t     m_mantissa;
+  const char  *m_literal;
+  size_t       m_literal_i;
+
+
+  bool run();
+
+  void start_document();
+  bool start_value   ();
+  bool end_value     ();
+  bool end_container ();
+  bool end_string    ();
+  bool end_number    ();
+  bool step_number   (char ch);
+  bool step_unicode  (char ch);
+
+  void     append_cp(uint32_t cp);
+  Position position (const char *pos);
+
+  bool error(const char *msg, Position pos);
+  bool error(const char *msg, const char *pos) { return error(msg, position(pos)); }
+  bool abort();
+  ERR  fail ();
+
+};
+
+
+#endif // !SOURCE_STREAM_PARSER_HPP
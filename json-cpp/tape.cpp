@@ -0,0 +1,358 @@
+#include "tape.hpp"
+#include "parser.hpp"
+#include "property.hpp"
+
+#include <cstring>
+
+
+static constexpr uint64_t Payload   = ((uint64_t)1 << 56) - 1;
+static constexpr uint64_t SideFlag  = (uint64_t)1 << 55;
+static constexpr uint64_t CountMask = 0xFFFFFF;
+static constexpr uint64_t MaxIndex  = 0xFFFFFFFF;
+
+static uint64_t make_word(char tag, uint64_t payload)
+{
+  return ((uint64_t)(uint8_t)tag << 56) | (payload & Payload);
+}
+
+static char word_tag(uint64_t word)
+{
+  return (char)(word >> 56);
+}
+
+
+class Json::Tape::Builder
+{
+public:
+
+  static constexpr bool Decode = true;
+  static constexpr bool Filter = false;
+
+  explicit Builder(Tape *tape) : m_tape(tape) {}
+
+  bool Null ()            { push('n', 0);                          return true; }
+  bool Bool (bool val)    { push(val ? 't' : 'f', 0);              return true; }
+  bool Int  (int64_t val) { push('l', 0); push_raw((uint64_t)val); return true; }
+  bool Float(double val)
+  {
+    uint64_t raw;
+    std::memcpy(&raw, &val, sizeof(raw));
+    push('d', 0);
+    push_raw(raw);
+    return true;
+  }
+
+  bool String(std::string_view str) { push_string(str); return true; }
+  bool Key   (std::string_view key) { push_string(key); return true; }
+
+  bool StartList  ()             { return open('[');       }
+  bool EndList    (size_t count) { return close(']', count); }
+  bool StartStruct()             { return open('{');       }
+  bool EndStruct  (size_t count) { return close('}', count); }
+
+private:
+
+  Tape                *m_tape;
+  std::vector<size_t>  m_stack;
+
+
+  void push(char tag, uint64_t payload)
+  {
+    m_tape->m_tape.push_back(make_word(tag, payload));
+  }
+
+  void push_raw(uint64_t raw)
+  {
+    m_tape->m_tape.push_back(raw);
+  }
+
+  void push_string(std::string_view str)
+  {
+    const std::string_view &input = m_tape->m_input;
+
+    if (
+      str.data() >= input.data() && str.data() < input.data() + input.size()
+    ) {
+      push('\"', (uint64_t)(str.data() - input.data()));
+    }
+    else {
+      push('\"', SideFlag | (uint64_t)m_tape->m_strings.size());
+      m_tape->m_strings.append(str);
+    }
+    push_raw(str.size());
+  }
+
+  bool open(char tag)
+  {
+    m_stack.push_back(m_tape->m_tape.size());
+    push(tag, 0);
+    return true;
+  }
+
+  bool close(char tag, size_t count)
+  {
+    size_t st  = m_stack.back();
+    size_t end = m_tape->m_tape.size();
+    m_stack.pop_back();
+
+    if (end > MaxIndex)
+      return false;
+
+    if (count > CountMask)
+      count = CountMask;
+
+    m_tape->m_tape[st] = make_word(
+      word_tag(m_tape->m_tape[st]), ((uint64_t)count << 32) | end
+    );
+    push(tag, st);
+    return true;
+  }
+
+};
+
+
+Json::Tape::Tape()
+{}
+
+
+Json::ERR Json::Tape::LoadFromFile(const std::filesystem::path &path)
+{
+  if (!m_file.Open(path))
+    return ERR::BAD_PATH;
+
+  return LoadFromString(m_file.GetData());
+}
+
+Json::ERR Json::Tape::LoadFromString(std::string_view json_string)
+{
+  if (json_string.data() != m_file.GetData().data())
+    m_file.Close();
+
+  m_tape.clear();
+  m_strings.clear();
+  m_input = json_string;
+  m_tape.reserve(json_string.size() / 4 + 2);
+
+  Builder builder(this);
+  if (
+    !Parser<Builder>(
+      json_string.data(), json_string.data() + json_string.size()
+    ).Parse(builder)
+  ) {
+    m_tape.clear();
+    m_strings.clear();
+    m_input = std::string_view();
+    return ERR::BAD_JSON;
+  }
+
+  return ERR::SUCCESS;
+}
+
+
+Json::Tape::View Json::Tape::GetData() const
+{
+  if (m_tape.empty())
+    throw Value::NotFound;
+
+  return View(this, 0);
+}
+
+
+Json::ValueType Json::Tape::View::GetType() const
+{
+  switch (word_tag(word(m_pos)))
+  {
+  case 't':
+  case 'f':  return Bool;
+  case 'l':  return Int;
+  case 'd':  return Float;
+  case '\"': return String;
+  case '[':  return List;
+  case '{':  return Struct;
+  default:   return Null;
+  }
+}
+
+
+bool Json::Tape::View::GetBool() const
+{
+  char tag = word_tag(word(m_pos));
+  if (tag != 't' && tag != 'f')
+    throw Value::WrongType;
+
+  return tag == 't';
+}
+
+int64_t Json::Tape::View::GetInt() const
+{
+  if (word_tag(word(m_pos)) != 'l')
+    throw Value::WrongType;
+
+  return (int64_t)word(m_pos + 1);
+}
+
+double Json::Tape::View::GetFloat() const
+{
+  if (word_tag(word(m_pos)) != 'd')
+    throw Value::WrongType;
+
+  uint64_t raw = word(m_pos + 1);
+  double   val;
+  std::memcpy(&val, &raw, sizeof(val));
+  return val;
+}
+
+std::string Json::Tape::View::GetString() const
+{
+  return std::string(GetStringView());
+}
+
+std::string_view Json::Tape::View::GetStringView() const
+{
+  if (word_tag(word(m_pos)) != '\"')
+    throw Value::WrongType;
+
+  return string(m_pos);
+}
+
+std::wstring Json::Tape::View::GetStringW() const
+{
+  return Json::to_wstr(GetStringView());
+}
+
+
+size_t Json::Tape::View::Size() const
+{
+  char tag = word_tag(word(m_pos));
+  if (tag != '[' && tag != '{')
+    throw Value::WrongType;
+
+  size_t count = (size_t)((word(m_pos) & Payload) >> 32);
+  if (count < CountMask)
+    return count;
+
+  size_t end = (size_t)(uint32_t)word(m_pos);
+  count = 0;
+  for (size_t pos = m_pos + 1; pos != end; pos = next(pos)) {
+    if (tag == '{')
+      pos += 2;
+    ++count;
+  }
+  return count;
+}
+
+bool Json::Tape::View::Contains(std::string_view prop_name) const
+{
+  if (word_tag(word(m_pos)) != '{')
+    throw Value::NotStruct;
+
+  size_t end = (size_t)(uint32_t)word(m_pos);
+  for (size_t pos = m_pos + 1; pos != end; pos = next(pos + 2))
+    if (string(pos) == prop_name)
+      return true;
+
+  return false;
+}
+
+bool Json::Tape::View::Contains(const std::wstring &prop_name) const
+{
+  return Contains(Json::to_str(prop_name));
+}
+
+
+Json::Tape::View Json::Tape::View::operator[](std::string_view prop_name) const
+{
+  if (word_tag(word(m_pos)) != '{')
+    throw Value::NotStruct;
+
+  size_t end = (size_t)(uint32_t)word(m_pos);
+  for (size_t pos = m_pos + 1; pos != end; pos = next(pos + 2))
+    if (string(pos) == prop_name)
+      return View(m_tape, pos + 2);
+
+  throw Value::NotFound;
+}
+
+Json::Tape::View Json::Tape::View::operator[](const std::wstring &prop_name) const
+{
+  return (*this)[Json::to_str(prop_name)];
+}
+
+Json::Tape::View Json::Tape::View::operator[](size_t i) const
+{
+  if (word_tag(word(m_pos)) != '[')
+    throw Value::NotList;
+
+  size_t end = (size_t)(uint32_t)word(m_pos);
+  for (size_t pos = m_pos + 1; pos != end; pos = next(pos), --i)
+    if (i == 0)
+      return View(m_tape, pos);
+
+  throw Value::NotFound;
+}
+
+
+Json::Value Json::Tape::View::ToValue() const
+{
+  switch (word_tag(word(m_pos)))
+  {
+  case 't':  return Value(true);
+  case 'f':  return Value(false);
+  case 'l':  return Value(GetInt());
+  case 'd':  return Value(GetFloat());
+  case '\"': return Value(StringType(string(m_pos)));
+  case '[': {
+    size_t   end = (size_t)(uint32_t)word(m_pos);
+    ListType list;
+
+    list.reserve(Size());
+    for (size_t pos = m_pos + 1; pos != end; pos = next(pos))
+      list.push_back(View(m_tape, pos).ToValue());
+    return Value(std::move(list));
+  }
+  case '{': {
+    size_t     end = (size_t)(uint32_t)word(m_pos);
+    StructType props;
+
+    props.reserve(Size());
+    for (size_t pos = m_pos + 1; pos != end; pos = next(pos + 2)) {
+      props.emplace_back(
+        StringType(string(pos)), View(m_tape, pos + 2).ToValue()
+      );
+    }
+    return Value(std::move(props));
+  }
+  default:
+    return Value();
+  }
+}
+
+
+size_t Json::Tape::View::next(size_t pos) const
+{
+  switch (word_tag(word(pos)))
+  {
+  case 'l':
+  case 'd':
+  case '\"':
+    return pos + 2;
+  case '[':
+  case '{':
+    return (size_t)(uint32_t)word(pos) + 1;
+  default:
+    return pos + 1;
+  }
+}
+
+std::string_view Json::Tape::View::string(size_t pos) const
+{
+  uint64_t payload = word(pos) & Payload;
+  size_t   size    = (size_t)word(pos + 1);
+
+  if (payload & SideFlag)
+    return std::string_view(
+      m_tape->m_strings.data() + (payload & ~SideFlag), size
+    );
+
+  return std::string_view(m_tape->m_input.data() + payload, size);
+}
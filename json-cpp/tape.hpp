@@ -0,0 +1,97 @@
+#ifndef SOURCE_TAPE_HPP
+#define SOURCE_TAPE_HPP
+
+
+#include "json.hpp"
+#include "value.hpp"
+#include "mapped_file.hpp"
+
+#include <string_view>
+
+
+// Read-only document stored as one flat array of tagged 64-bit words.
+// The top byte of a word is its tag, the low 56 bits its payload:
+//
+//   'n' 't' 'f'   null / true / false
+//   'l' 'd'       int64 / double, raw bits in the next word
+//   '"'           string offset, length in the next word
+//   '[' '{'       element count << 32 | index of the closing word
+//   ']' '}'       index of the opening word
+//
+// The closing index has 32 bits, so a document whose tape would pass 4G
+// words (32 GB) fails to load with ERR::BAD_JSON. Counts above 2^24 - 1
+// are stored as 2^24 - 1 and Size() counts such containers by walking
+// them.
+//
+// Struct members are stored as a string word for the name followed by the
+// value. Strings without escapes point into the input, which therefore
+// must outlive the tape when loaded with LoadFromString.
+class Json::Tape
+{
+public:
+
+  class View;
+
+  Tape();
+
+  Tape(const Tape &tape)            = delete;
+  Tape& operator=(const Tape &tape) = delete;
+
+  ERR LoadFromFile  (const std::filesystem::path &path);
+  ERR LoadFromString(std::string_view             json_string);
+
+  View GetData() const;
+
+private:
+
+  class Builder;
+
+  std::vector<uint64_t> m_tape;
+  std::string           m_strings;
+  MappedFile            m_file;
+  std::string_view      m_input;
+
+};
+
+
+class Json::Tape::View
+{
+public:
+
+  ValueType GetType() const;
+
+  bool             GetBool      () const;
+  int64_t          GetInt       () const;
+  double           GetFloat     () const;
+  std::string      GetString    () const;
+  std::string_view GetStringView() const;
+  std::wstring     GetStringW   () const;
+
+  size_t Size    ()                              const;
+  bool   Contains(std::string_view    prop_name) const;
+  bool   Contains(const std::wstring &prop_name) const;
+
+  View operator[](std::string_view    prop_name) const;
+  View operator[](const std::wstring &prop_name) const;
+  View operator[](size_t              i)         const;
+
+  Value ToValue() const;
+
+private:
+
+  const Tape *m_tape;
+  size_t      m_pos;
+
+
+  View(const Tape *tape, size_t pos) : m_tape(tape), m_pos(pos) {}
+
+  uint64_t         word  (size_t pos) const { return m_tape->m_tape[pos]; }
+  size_t           next  (size_t pos) const;
+  std::string_view string(size_t pos) const;
+
+  friend class Json::Tape;
+
+};
+
+
+#endif // !SOURCE_TAPE_HPP
@@ -0,0 +1,95 @@
+#include "thread_pool.hpp"
+
+
+Json::ThreadPool::ThreadPool(size_t threads) :
+  m_task(nullptr), m_count(0), m_next(0), m_busy(0),
+  m_generation(0), m_stop(false)
+{
+  if (threads == 0)
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+  m_workers.reserve(threads - 1);
+  for (size_t i = 1; i < threads; ++i)
+    m_workers.emplace_back(&ThreadPool::work, this);
+}
+
+Json::ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_start.notify_all();
+
+  for (std::thread &worker : m_workers)
+    worker.join();
+}
+
+
+void Json::ThreadPool::Run(size_t count, const std::function<void(size_t)> &task)
+{
+  if (m_workers.empty() || count <= 1) {
+    for (size_t i = 0; i < count; ++i)
+      task(i);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_task  = &task;
+    m_count = count;
+    m_next  = 0;
+    m_busy  = m_workers.size();
+    ++m_generation;
+  }
+  m_start.notify_all();
+
+  drain();
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this] { return m_busy == 0; });
+  m_task = nullptr;
+
+  std::exception_ptr error = std::move(m_error);
+  m_error = nullptr;
+  lock.unlock();
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+
+void Json::ThreadPool::work()
+{
+  uint64_t seen = 0;
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_start.wait(lock, [&] { return m_stop || m_generation != seen; });
+      if (m_stop)
+        return;
+      seen = m_generation;
+    }
+
+    drain();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_busy == 0)
+      m_done.notify_one();
+  }
+}
+
+void Json::ThreadPool::drain()
+{
+  try {
+    for (size_t i = m_next++; i < m_count; i = m_next++)
+      (*m_task)(i);
+  }
+  catch (...) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_error)
+      m_error = std::current_exception();
+    m_next = m_count;
+  }
+}
@@ -0,0 +1,57 @@
+#ifndef SOURCE_THREAD_POOL_HPP
+#define SOURCE_THREAD_POOL_HPP
+
+
+#include "json.hpp"
+
+#include <atomic>
+#include <exception>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+
+// Fixed set of worker threads running one indexed job at a time. The
+// calling thread takes part in Run(), so a pool of size 1 has no workers
+// and runs everything inline.
+class Json::ThreadPool
+{
+public:
+
+  // 0 picks one thread per hardware core.
+  explicit ThreadPool(size_t threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &pool)            = delete;
+  ThreadPool& operator=(const ThreadPool &pool) = delete;
+
+  size_t Size() const { return m_workers.size() + 1; }
+
+  // Calls task(i) for every i in [0, count) and returns when all are done.
+  // If a task throws, the tasks not yet started are skipped and the first
+  // exception is rethrown once every thread has stopped.
+  void Run(size_t count, const std::function<void(size_t)> &task);
+
+private:
+
+  std::vector<std::thread>                m_workers;
+  std::mutex                              m_mutex;
+  std::condition_variable                 m_start;
+  std::condition_variable                 m_done;
+  const std::function<void(size_t)>      *m_task;
+  size_t                                  m_count;
+  std::atomic<size_t>                     m_next;
+  size_t                                  m_busy;
+  uint64_t                                m_generation;
+  bool                                    m_stop;
+  std::exception_ptr                      m_error;
+
+
+  void work();
+  void drain();
+
+};
+
+
+#endif // !SOURCE_THREAD_POOL_HPP
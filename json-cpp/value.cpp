@@ -1,35 +1,75 @@
 #include "value.hpp"
 #include "property.hpp"
+#include "pointer.hpp"
 
-#include <algorithm>
+#include <cstring>
+#include <utility>
 
 
-Json::Value::Value(const Value &val)
+Json::Value::Value(const Value &val) :
+  Value(val, std::pmr::get_default_resource())
+{}
+
+Json::Value::Value(Value &&val) noexcept
 {
-  m_type = val.m_type;
+  take(val);
+}
+
+Json::Value::Value(const Value &val, std::pmr::memory_resource *res)
+{
+  m_type  = Null;
+  m_value = nullptr;
+
   switch (val.m_type)
   {
   case Bool:
-    m_value = new bool(*(bool*)val.m_value);
+    m_bool = val.m_bool;
     break;
   case Int:
-    m_value = new int64_t(*(int64_t*)val.m_value);
+    m_int = val.m_int;
     break;
   case Float:
-    m_value = new double(*(double*)val.m_value);
+    m_float = val.m_float;
     break;
   case String:
-    m_value = new std::wstring(*(std::wstring*)val.m_value);
+    m_value = create<StringType>(res, *(StringType*)val.m_value, res);
     break;
   case List:
-    m_value = new ListType(*(ListType*)val.m_value);
+    m_value = create<ListType>(res, res);
     break;
   case Struct:
-    m_value = new StructType(*(StructType*)val.m_value);
+    m_value = create<StructData>(res, res);
     break;
   default:
     break;
   }
+  m_type = val.m_type;
+
+  try {
+    if (m_type == List) {
+      const ListType &src  = *(ListType*)val.m_value;
+      ListType       &list = *(ListType*)m_value;
+
+      list.reserve(src.size());
+      for (auto &item : src)
+        list.emplace_back(item, res);
+    }
+    else if (m_type == Struct) {
+      const StructData &src  = *(StructData*)val.m_value;
+      StructData       &data = *(StructData*)m_value;
+
+      data.props.reserve(src.props.size());
+      for (auto &prop : src.props)
+        data.props.push_back(
+          Property(prop.GetNameView(), res, Value(prop.m_value, res))
+        );
+      data.index = src.index;
+    }
+  }
+  catch (...) {
+    clear();
+    throw;
+  }
 }
 
 
@@ -41,59 +81,97 @@ Json::Value::Value()
 
 Json::Value::Value(bool val)
 {
-  m_type  = Bool;
-  m_value = new bool(val);
+  m_type = Bool;
+  m_bool = val;
 }
 
 Json::Value::Value(const char *val)
 {
-  std::string t(val);
+  auto *res = std::pmr::get_default_resource();
 
+  m_value = create<StringType>(res, val, res);
   m_type  = String;
-  m_value = new std::wstring(t.begin(), t.end());
-
 }
 
 Json::Value::Value(const std::string &val)
 {
+  auto *res = std::pmr::get_default_resource();
+
+  m_value = create<StringType>(res, val.data(), val.size(), res);
   m_type  = String;
-  m_value = new std::wstring(val.begin(), val.end());
 }
 
-Json::Value::Value(const wchar_t *val)
+Json::Value::Value(StringType &&val)
 {
+  auto *res = val.get_allocator().resource();
+
+  m_value = create<StringType>(res, std::move(val), res);
   m_type  = String;
-  m_value = new std::wstring(val);
 }
 
-Json::Value::Value(const std::wstring &val)
+Json::Value::Value(const wchar_t *val) :
+  Value(Json::to_str(val))
+{}
+
+Json::Value::Value(const std::wstring &val) :
+  Value(Json::to_str(val))
+{}
+
+Json::Value::Value(const ListType &val)
 {
-  m_type  = String;
-  m_value = new std::wstring(val);
+  auto *res = std::pmr::get_default_resource();
+
+  m_value = create<ListType>(res, val, res);
+  m_type  = List;
 }
 
-Json::Value::Value(const ListType &val)
+Json::Value::Value(ListType &&val)
 {
+  auto *res = val.get_allocator().resource();
+
+  m_value = create<ListType>(res, std::move(val), res);
   m_type  = List;
-  m_value = new ListType(val);
 }
 
 Json::Value::Value(const std::initializer_list<Value> &val)
 {
+  auto *res = std::pmr::get_default_resource();
+
+  m_value = create<ListType>(res, val, res);
   m_type  = List;
-  m_value = new ListType(val);
 }
 
 Json::Value::Value(const StructType &val)
 {
+  auto *res  = std::pmr::get_default_resource();
+  auto *data = create<StructData>(res, res);
+
+  m_value = data;
   m_type  = Struct;
-  m_value = new StructType(val);
+
+  data->props = val;
+}
+
+Json::Value::Value(StructType &&val)
+{
+  auto *res  = val.get_allocator().resource();
+  auto *data = create<StructData>(res, res);
+
+  m_value = data;
+  m_type  = Struct;
+
+  data->props = std::move(val);
 }
 
 Json::Value::Value(const std::initializer_list<Property> &val)
 {
+  auto *res  = std::pmr::get_default_resource();
+  auto *data = create<StructData>(res, res);
+
+  m_value = data;
   m_type  = Struct;
-  m_value = new StructType(val);
+
+  data->props = val;
 }
 
 
@@ -103,16 +181,18 @@ Json::Value::~Value()
 }
 
 
-bool Json::Value::Contains(const std::wstring &prop_name) const
+bool Json::Value::Contains(std::string_view prop_name) const
 {
   if (m_type != Struct)
     return false;
 
-  for (auto &prop : *(StructType*)m_value)
-    if (prop.GetNameW() == prop_name)
-      return true;
+  auto *data = (StructData*)m_value;
+  return data->index.Find(data->props, prop_name) != KeyIndex::npos;
+}
 
-  return false;
+bool Json::Value::Contains(const std::wstring &prop_name) const
+{
+  return Contains(Json::to_str(prop_name));
 }
 
 
@@ -121,7 +201,7 @@ bool Json::Value::GetBool() const
   if (m_type != Bool)
     throw WrongType;
 
-  return *(bool*)m_value;
+  return m_bool;
 }
 
 int64_t Json::Value::GetInt() const
@@ -129,7 +209,7 @@ int64_t Json::Value::GetInt() const
   if (m_type != Int)
     throw WrongType;
 
-  return *(int64_t*)m_value;
+  return m_int;
 }
 
 double Json::Value::GetFloat() const
@@ -137,7 +217,7 @@ double Json::Value::GetFloat() const
   if (m_type != Float)
     throw WrongType;
 
-  return *(double*)m_value;
+  return m_float;
 }
 
 std::string Json::Value::GetString() const
@@ -145,7 +225,16 @@ std::string Json::Value::GetString() const
   if (m_type != String)
     throw WrongType;
 
-  return Json::to_str(*(std::wstring*)m_value);
+  auto *str = (StringType*)m_value;
+  return std::string(str->data(), str->size());
+}
+
+std::string_view Json::Value::GetStringView() const
+{
+  if (m_type != String)
+    throw WrongType;
+
+  return *(StringType*)m_value;
 }
 
 std::wstring Json::Value::GetStringW() const
@@ -153,7 +242,7 @@ std::wstring Json::Value::GetStringW() const
   if (m_type != String)
     throw WrongType;
 
-  return *(std::wstring*)m_value;
+  return Json::to_wstr(*(StringType*)m_value);
 }
 
 Json::ListType Json::Value::GetList() const
@@ -164,106 +253,276 @@ Json::ListType Json::Value::GetList() const
   return *(ListType*)m_value;
 }
 
+const Json::ListType& Json::Value::GetListRef() const
+{
+  if (m_type != List)
+    throw WrongType;
+
+  return *(ListType*)m_value;
+}
+
+Json::Value::ListView Json::Value::GetListView() const
+{
+  auto &list = GetListRef();
+  return ListView(list.data(), list.data() + list.size());
+}
+
 Json::StructType Json::Value::GetStruct() const
 {
   if (m_type != Struct)
     throw WrongType;
 
-  return *(StructType*)m_value;
+  return ((StructData*)m_value)->props;
 }
 
+const Json::StructType& Json::Value::GetStructRef() const
+{
+  if (m_type != Struct)
+    throw WrongType;
+
+  return ((StructData*)m_value)->props;
+}
 
-void Json::Value::RemoveProperty(const std::string &name)
+Json::Value::StructView Json::Value::GetStructView() const
 {
-  RemoveProperty(std::wstring(name.begin(), name.end()));
+  if (m_type != Struct)
+    throw WrongType;
+
+  return StructView((StructData*)m_value);
+}
+
+
+size_t Json::Value::Size() const
+{
+  if (m_type == List)
+    return ((ListType*)m_value)->size();
+  if (m_type == Struct)
+    return ((StructData*)m_value)->props.size();
+
+  throw WrongType;
 }
 
+
 void Json::Value::RemoveProperty(const std::wstring &name)
+{
+  RemoveProperty(Json::to_str(name));
+}
+
+void Json::Value::RemoveProperty(std::string_view name)
 {
   if (m_type != Struct)
     throw NotStruct;
 
-  auto f = std::find_if(
-    ((StructType*)m_value)->begin(),
-    ((StructType*)m_value)->end(),
-    [&](const Property &p_prop)
-    {
-      return p_prop.GetNameW() == name;
-    }
-  );
-  if (f == ((StructType*)m_value)->end())
+  auto *data = (StructData*)m_value;
+
+  size_t i = data->index.Find(data->props, name);
+  if (i == KeyIndex::npos)
     throw NotFound;
-  
-  ((StructType*)m_value)->erase(f);
+
+  data->props.erase(data->props.begin() + i);
+  data->index.Clear();
 }
 
 
-Json::Value& Json::Value::operator=(const Json::Value& val)
+Json::Value& Json::Value::At(std::string_view pointer)
 {
-  if (m_value)
-    clear();
+  return At(Pointer(pointer));
+}
 
-  m_type = val.m_type;
-  switch (val.m_type)
-  {
-  case Bool:
-    m_value = new bool(*(bool*)val.m_value);
-    break;
-  case Int:
-    m_value = new int64_t(*(int64_t*)val.m_value);
-    break;
-  case Float:
-    m_value = new double(*(double*)val.m_value);
-    break;
-  case String:
-    m_value = new std::wstring(*(std::wstring*)val.m_value);
-    break;
-  case List:
-    m_value = new ListType(*(ListType*)val.m_value);
-    break;
-  case Struct:
-    m_value = new StructType(*(StructType*)val.m_value);
-    break;
-  default:
-    break;
+const Json::Value& Json::Value::At(std::string_view pointer) const
+{
+  return At(Pointer(pointer));
+}
+
+Json::Value& Json::Value::At(const Pointer &pointer)
+{
+  return const_cast<Value&>(std::as_const(*this).At(pointer));
+}
+
+const Json::Value& Json::Value::At(const Pointer &pointer) const
+{
+  const Value *val = find(pointer, pointer.Size());
+  if (!val)
+    throw NotFound;
+
+  return *val;
+}
+
+Json::Value* Json::Value::Find(std::string_view pointer)
+{
+  return Find(Pointer(pointer));
+}
+
+const Json::Value* Json::Value::Find(std::string_view pointer) const
+{
+  return Find(Pointer(pointer));
+}
+
+Json::Value* Json::Value::Find(const Pointer &pointer)
+{
+  return const_cast<Value*>(find(pointer, pointer.Size()));
+}
+
+const Json::Value* Json::Value::Find(const Pointer &pointer) const
+{
+  return find(pointer, pointer.Size());
+}
+
+Json::Value& Json::Value::Set(std::string_view pointer, Value val)
+{
+  return Set(Pointer(pointer), std::move(val));
+}
+
+Json::Value& Json::Value::Set(const Pointer &pointer, Value val)
+{
+  Value *cur = this;
+
+  for (size_t i = 0; i < pointer.Size(); ++i) {
+    const Pointer::Token &token = pointer.m_tokens[i];
+    const bool            last  = i + 1 == pointer.Size();
+
+    if (cur->m_type == Struct) {
+      auto *data = (StructData*)cur->m_value;
+
+      size_t j = data->index.Find(data->props, token.name, token.hash);
+      if (j == KeyIndex::npos) {
+        data->props.push_back(Property(
+          token.name, data->props.get_allocator().resource(),
+          last ? Value() : Value(StructType())
+        ));
+        j = data->props.size() - 1;
+        data->index.Insert(data->props, j);
+      }
+      cur = &data->props[j].m_value;
+    }
+    else if (cur->m_type == List) {
+      auto *list = (ListType*)cur->m_value;
+
+      if (token.index == Pointer::End || token.index == list->size()) {
+        list->push_back(last ? Value() : Value(StructType()));
+        cur = &list->back();
+      }
+      else if (token.index < list->size()) {
+        cur = &(*list)[token.index];
+      }
+      else {
+        throw NotFound;
+      }
+    }
+    else {
+      throw NotFound;
+    }
   }
 
-  return *this;
+  return *cur = std::move(val);
 }
 
-Json::Value& Json::Value::operator[](const std::string &prop_name)
+bool Json::Value::Erase(std::string_view pointer)
 {
-  return (*this)[std::wstring(prop_name.begin(), prop_name.end())];
+  return Erase(Pointer(pointer));
 }
 
-const Json::Value& Json::Value::operator[](const std::string &prop_name) const
+bool Json::Value::Erase(const Pointer &pointer)
 {
-  return (*this)[std::wstring(prop_name.begin(), prop_name.end())];
+  if (pointer.Size() == 0)
+    return false;
+
+  auto *parent = const_cast<Value*>(find(pointer, pointer.Size() - 1));
+  if (!parent)
+    return false;
+
+  const Pointer::Token &token = pointer.m_tokens.back();
+
+  if (parent->m_type == Struct) {
+    auto *data = (StructData*)parent->m_value;
+
+    size_t i = data->index.Find(data->props, token.name, token.hash);
+    if (i == KeyIndex::npos)
+      return false;
+
+    data->props.erase(data->props.begin() + i);
+    data->index.Clear();
+    return true;
+  }
+
+  if (parent->m_type == List) {
+    auto *list = (ListType*)parent->m_value;
+    if (token.index >= list->size())
+      return false;
+
+    list->erase(list->begin() + token.index);
+    return true;
+  }
+
+  return false;
+}
+
+
+Json::Value& Json::Value::operator=(const Json::Value& val)
+{
+  if (this == &val)
+    return *this;
+
+  Value copy(val);
+  clear();
+  take(copy);
+
+  return *this;
+}
+
+Json::Value& Json::Value::operator=(Json::Value &&val) noexcept
+{
+  if (this == &val)
+    return *this;
+
+  // val may live inside this value, which clear() frees.
+  Value tmp(std::move(val));
+  clear();
+  take(tmp);
+
+  return *this;
 }
 
 Json::Value& Json::Value::operator[](const std::wstring &prop_name)
+{
+  return (*this)[Json::to_str(prop_name)];
+}
+
+const Json::Value& Json::Value::operator[](const std::wstring &prop_name) const
+{
+  return (*this)[Json::to_str(prop_name)];
+}
+
+Json::Value& Json::Value::operator[](std::string_view prop_name)
 {
   if (m_type != Struct)
     throw NotStruct;
 
-  for (auto &prop : *(StructType*)m_value)
-    if (prop.GetNameW() == prop_name)
-      return prop.GetValue();
+  auto *data = (StructData*)m_value;
+
+  size_t i = data->index.Find(data->props, prop_name);
+  if (i != KeyIndex::npos)
+    return data->props[i].GetValue();
 
-  ((StructType*)m_value)->push_back(Property(prop_name, Value()));
-  return (((StructType*)m_value)->end() - 1)->GetValue();
+  data->props.push_back(
+    Property(prop_name, data->props.get_allocator().resource(), Value())
+  );
+  data->index.Insert(data->props, data->props.size() - 1);
+  return data->props.back().GetValue();
 }
 
-const Json::Value& Json::Value::operator[](const std::wstring &prop_name) const
+const Json::Value& Json::Value::operator[](std::string_view prop_name) const
 {
   if (m_type != Struct)
     throw NotStruct;
 
-  for (auto const &prop : *(StructType*)m_value)
-    if (prop.GetNameW() == prop_name)
-      return prop.GetValue();
-  
-  throw NotFound;
+  auto *data = (StructData*)m_value;
+
+  size_t i = data->index.Find(data->props, prop_name);
+  if (i == KeyIndex::npos)
+    throw NotFound;
+
+  return data->props[i].GetValue();
 }
 
 Json::Value& Json::Value::operator[](size_t i)
@@ -292,32 +551,23 @@ const Json::Value& Json::Value::operator[](size_t i) const
 
 void Json::Value::clear()
 {
-  if (m_value == nullptr) {
-    m_type = Null;
-    return;
-  }
-
   switch (m_type)
   {
-  case Bool:
-    delete (bool*)m_value;
-    break;
-  case Int:
-    delete (int64_t*)m_value;
-    break;
-  case Float:
-    delete (double*)m_value;
+  case String: {
+    auto *str = (StringType*)m_value;
+    destroy(str, str->get_allocator().resource());
     break;
-  case String:
-    ((std::wstring*)m_value)->clear();
-    delete (std::wstring*)m_value;
-    break;
-  case List:
-    delete (ListType*)m_value;
+  }
+  case List: {
+    auto *list = (ListType*)m_value;
+    destroy(list, list->get_allocator().resource());
     break;
-  case Struct:
-    delete (StructType*)m_value;
+  }
+  case Struct: {
+    auto *data = (StructData*)m_value;
+    destroy(data, data->props.get_allocator().resource());
     break;
+  }
   default:
     break;
   }
@@ -325,3 +575,40 @@ void Json::Value::clear()
   m_value = nullptr;
 }
 
+const Json::Value* Json::Value::find(const Pointer &pointer, size_t count) const
+{
+  const Value *cur = this;
+
+  for (size_t i = 0; i < count; ++i) {
+    const Pointer::Token &token = pointer.m_tokens[i];
+
+    if (cur->m_type == Struct) {
+      auto *data = (StructData*)cur->m_value;
+
+      size_t j = data->index.Find(data->props, token.name, token.hash);
+      if (j == KeyIndex::npos)
+        return nullptr;
+      cur = &data->props[j].m_value;
+    }
+    else if (cur->m_type == List) {
+      auto *list = (ListType*)cur->m_value;
+      if (token.index >= list->size())
+        return nullptr;
+      cur = &(*list)[token.index];
+    }
+    else {
+      return nullptr;
+    }
+  }
+
+  return cur;
+}
+
+void Json::Value::take(Value &val) noexcept
+{
+  m_type = val.m_type;
+  std::memcpy(&m_int, &val.m_int, sizeof(m_int));
+
+  val.m_type  = Null;
+  val.m_value = nullptr;
+}
@@ -3,8 +3,12 @@
 
 
 #include "json.hpp"
+#include "key_index.hpp"
 
+#include <cstddef>
 #include <functional>
+#include <string_view>
+#include <type_traits>
 
 
 class Json::Value
@@ -16,21 +20,30 @@ public:
     NotFound,
     NotList,
     NotStruct,
-    WrongType
+    WrongType,
+    BadPointer
   };
 
+  class ListView;
+  class StructView;
+
 
   Value(const Value &val);
+  Value(Value      &&val) noexcept;
+  Value(const Value &val, std::pmr::memory_resource *res);
 
   Value();
   Value(bool                                   val);
   Value(const char                            *val);
   Value(const std::string                     &val);
+  Value(StringType                           &&val);
   Value(const wchar_t                         *val);
   Value(const std::wstring                    &val);
   Value(const ListType                        &val);
+  Value(ListType                             &&val);
   Value(const std::initializer_list<Value>    &val);
   Value(const StructType                      &val);
+  Value(StructType                           &&val);
   Value(const std::initializer_list<Property> &val);
 
   template <typename T>
@@ -48,32 +61,71 @@ public:
   ~Value();
 
 
+  bool Contains(std::string_view    prop_name) const;
   bool Contains(const std::wstring &prop_name) const;
 
   ValueType GetType() const { return m_type; }
 
-  bool         GetBool   () const;
-  int64_t      GetInt    () const;
-  double       GetFloat  () const;
-  std::string  GetString () const;
-  std::wstring GetStringW() const;
-  ListType     GetList   () const;
-  StructType   GetStruct () const;
-
-  void RemoveProperty(const std::string  &name);
+  // GetString, GetList and GetStruct return copies; the views and
+  // references below read the value in place and stay valid until it is
+  // modified.
+  bool              GetBool      () const;
+  int64_t           GetInt       () const;
+  double            GetFloat     () const;
+  std::string       GetString    () const;
+  std::string_view  GetStringView() const;
+  std::wstring      GetStringW   () const;
+  ListType          GetList      () const;
+  const ListType&   GetListRef   () const;
+  ListView          GetListView  () const;
+  StructType        GetStruct    () const;
+  const StructType& GetStructRef () const;
+  StructView        GetStructView() const;
+
+  // Number of elements of a list or properties of a struct.
+  size_t Size() const;
+
+  // Calls vis with the content of the value as one of std::nullptr_t,
+  // bool, int64_t, double, std::string_view, ListView or StructView and
+  // returns its result:
+  //
+  //   val.Visit([](auto &&x) { ... });
+  template <typename Visitor>
+  auto Visit(Visitor &&vis) const -> std::invoke_result_t<Visitor, std::nullptr_t>;
+
+  void RemoveProperty(std::string_view    name);
   void RemoveProperty(const std::wstring &name);
 
+  // RFC 6901 JSON Pointers such as "/routes/3/path"; the string overloads
+  // throw BadPointer when the pointer is malformed. At throws NotFound and
+  // Find returns null when nothing is there. Set creates missing struct
+  // members on the way and appends to a list for "-" or the index one
+  // past the end. Erase returns whether something was removed.
+  Value&        At   (std::string_view pointer);
+  const Value&  At   (std::string_view pointer) const;
+  Value&        At   (const Pointer    &pointer);
+  const Value&  At   (const Pointer    &pointer) const;
+  Value*        Find (std::string_view pointer);
+  const Value*  Find (std::string_view pointer) const;
+  Value*        Find (const Pointer    &pointer);
+  const Value*  Find (const Pointer    &pointer) const;
+  Value&        Set  (std::string_view pointer, Value val);
+  Value&        Set  (const Pointer    &pointer, Value val);
+  bool          Erase(std::string_view pointer);
+  bool          Erase(const Pointer    &pointer);
+
 
   Value& operator=(const Value &val);
+  Value& operator=(Value      &&val) noexcept;
 
   template <typename T>
   Value& operator=(T val)
   {
-    return *this = Value(val);
+    return *this = Value(std::move(val));
   }
 
-  Value&        operator[] (const std::string  &prop_name);
-  const Value&  operator[] (const std::string  &prop_name) const;
+  Value&        operator[] (std::string_view    prop_name);
+  const Value&  operator[] (std::string_view    prop_name) const;
   Value&        operator[] (const std::wstring &prop_name);
   const Value&  operator[] (const std::wstring &prop_name) const;
 
@@ -82,21 +134,64 @@ public:
   
 private:
 
+  struct StructData
+  {
+    StructType props;
+    KeyIndex   index;
+
+    explicit StructData(std::pmr::memory_resource *res) :
+      props(res)
+    {}
+  };
+
+
   ValueType m_type;
-  void*     m_value;
+  union
+  {
+    bool    m_bool;
+    int64_t m_int;
+    double  m_float;
+    void   *m_value;
+  };
 
 
   void clear();
+  void take(Value &val) noexcept;
 
-  friend bool         Json::validate_value(
-    const std::wstring &json_str, std::string *log, uint64_t ln, uint64_t col
-  );
-  friend std::wstring Json::serialize_value(
-    const Value        &val
-  );
-  friend void         Json::deserialize_value(
-    const std::wstring &json_str, Value *val
-  );
+  const Value* find(const Pointer &pointer, size_t count) const;
+
+  template <typename T, typename... Args>
+  static T* create(std::pmr::memory_resource *res, Args &&...args);
+
+  template <typename T>
+  static void destroy(T *ptr, std::pmr::memory_resource *res);
+
+  friend class Json::DomBuilder;
+  friend class Json::Writer;
+
+};
+
+
+// Contiguous read-only range of list elements.
+class Json::Value::ListView
+{
+public:
+
+  ListView() : m_first(nullptr), m_last(nullptr) {}
+  ListView(const Value *first, const Value *last) : m_first(first), m_last(last) {}
+
+  const Value* begin() const { return m_first; }
+  const Value* end  () const { return m_last;  }
+
+  size_t Size () const { return m_last - m_first; }
+  bool   Empty() const { return m_first == m_last; }
+
+  const Value& operator[](size_t i) const { return m_first[i]; }
+
+private:
+
+  const Value *m_first;
+  const Value *m_last;
 
 };
 
@@ -107,17 +202,17 @@ Json::Value::Value(T val)
   static_assert(
     std::is_integral_v<T>       ||
     std::is_floating_point_v<T>,
-    "Iterator value type must be "
-    "Json::Value or Json::Property"
+    "Value type must be an "
+    "integral or floating-point type"
   );
 
-  if (std::is_integral_v<T>) {
-    m_type  = Int;
-    m_value = new int64_t(val);
+  if constexpr (std::is_integral_v<T>) {
+    m_type = Int;
+    m_int  = val;
   }
   else {
     m_type  = Float;
-    m_value = new double(val);
+    m_float = val;
   }
 }
 
@@ -133,29 +228,25 @@ Json::Value::Value(It it_first, It it_last)
     "Json::Value or Json::Property"
   );
 
-  if constexpr (std::is_same_v<value_type, Value>) {
-    m_type  = List;
-    m_value = new ListType;
-
-    for (; it_first != it_last; ++it_first)
-      ((ListType*)m_value)->push_back(*it_first);
-  }
-  else {
-    m_type  = Struct;
-    m_value = new StructType;
+  m_type  = Null;
+  m_value = nullptr;
 
-    for (; it_first != it_last; ++it_first)
-      ((StructType*)m_value)->push_back(*it_first);
-  }
+  if constexpr (std::is_same_v<value_type, Value>)
+    *this = ListType(it_first, it_last);
+  else
+    *this = StructType(it_first, it_last);
 }
 
 template <typename It, typename T>
 Json::Value::Value(It it_first, It it_last, const std::function<Value(T &val)> &to_value)
 {
-  m_type  = List;
-  m_value = new ListType;
+  ListType list;
   for (; it_first != it_last; ++it_first)
-    ((ListType*)m_value)->push_back(to_value(*it_first));
+    list.push_back(to_value(*it_first));
+
+  m_type  = Null;
+  m_value = nullptr;
+  *this = std::move(list);
 }
 
 
@@ -164,10 +255,34 @@ Json::Value::Value(
   It it_first, It it_last, const std::function<Property(T &val)> &to_prop
 )
 {
-  m_type  = Struct;
-  m_value = new StructType;
+  StructType props;
   for (; it_first != it_last; ++it_first)
-    ((StructType*)m_value)->push_back(to_prop(*it_first));
+    props.push_back(to_prop(*it_first));
+
+  m_type  = Null;
+  m_value = nullptr;
+  *this = std::move(props);
+}
+
+
+template <typename T, typename... Args>
+T* Json::Value::create(std::pmr::memory_resource *res, Args &&...args)
+{
+  void *ptr = res->allocate(sizeof(T), alignof(T));
+  try {
+    return new (ptr) T(std::forward<Args>(args)...);
+  }
+  catch (...) {
+    res->deallocate(ptr, sizeof(T), alignof(T));
+    throw;
+  }
+}
+
+template <typename T>
+void Json::Value::destroy(T *ptr, std::pmr::memory_resource *res)
+{
+  ptr->~T();
+  res->deallocate(ptr, sizeof(T), alignof(T));
 }
 
 
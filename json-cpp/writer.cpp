@@ -0,0 +1,260 @@
+#include "writer.hpp"
+#include "property.hpp"
+#include "number.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+static constexpr size_t StreamBufferSize = 64 * 1024;
+
+
+Json::Writer::Writer() :
+  m_mode(GROW), m_out(&m_string), m_stream(nullptr),
+  m_first(nullptr), m_cur(nullptr), m_last(nullptr)
+{}
+
+Json::Writer::Writer(char *buffer, size_t size) :
+  m_mode(FIXED), m_out(nullptr), m_stream(nullptr),
+  m_first(buffer), m_cur(buffer), m_last(buffer + size)
+{}
+
+Json::Writer::Writer(std::string &out) :
+  m_mode(APPEND), m_out(&out), m_stream(nullptr),
+  m_first(nullptr), m_cur(nullptr), m_last(nullptr)
+{}
+
+Json::Writer::Writer(std::ostream &stream) :
+  m_mode(STREAM), m_string(StreamBufferSize, '\0'), m_out(nullptr),
+  m_stream(&stream)
+{
+  m_first = m_cur = m_string.data();
+  m_last  = m_first + m_string.size();
+}
+
+
+bool Json::Writer::Write(const Value &val)
+{
+  if (m_mode == GROW)
+    m_string.clear();
+
+  m_cur = m_first;
+  m_pending.clear();
+  m_stack.clear();
+  m_stack.push_back({ &val, Open });
+
+  return run();
+}
+
+bool Json::Writer::Resume()
+{
+  if (m_mode != FIXED)
+    return run();
+
+  m_cur = m_first;
+
+  size_t size = std::min(m_pending.size(), (size_t)(m_last - m_cur));
+  std::memcpy(m_cur, m_pending.data(), size);
+  m_cur += size;
+  m_pending.erase(0, size);
+
+  return run();
+}
+
+
+const char* Json::Writer::Data() const
+{
+  return m_out ? m_out->data() : m_first;
+}
+
+size_t Json::Writer::Size() const
+{
+  return m_out ? m_out->size() : (size_t)(m_cur - m_first);
+}
+
+std::string Json::Writer::Release()
+{
+  if (m_mode == GROW)
+    return std::move(m_string);
+
+  return std::string(Data(), Size());
+}
+
+
+bool Json::Writer::run()
+{
+  while (!m_stack.empty()) {
+    if (!m_pending.empty())
+      return false;
+
+    Frame       &top = m_stack.back();
+    const Value &val = *top.val;
+
+    if (val.m_type == List) {
+      const ListType &list = *(ListType*)val.m_value;
+
+      if (top.i == Open) {
+        put('[');
+        top.i = 0;
+      }
+      else if (top.i == list.size()) {
+        put(']');
+        m_stack.pop_back();
+      }
+      else {
+        if (top.i != 0)
+          put(',');
+        m_stack.push_back({ &list[top.i++], Open });
+      }
+    }
+    else if (val.m_type == Struct) {
+      const StructType &props = ((Value::StructData*)val.m_value)->props;
+
+      if (top.i == Open) {
+        put('{');
+        top.i = 0;
+      }
+      else if (top.i == props.size()) {
+        put('}');
+        m_stack.pop_back();
+      }
+      else {
+        const Property &prop = props[top.i++];
+
+        if (top.i != 1)
+          put(',');
+        put_string(prop.GetNameView());
+        put(':');
+        m_stack.push_back({ &prop.m_value, Open });
+      }
+    }
+    else {
+      put_scalar(val);
+      m_stack.pop_back();
+    }
+  }
+
+  if (!m_pending.empty())
+    return false;
+
+  if (m_mode == STREAM)
+    flush();
+  return true;
+}
+
+void Json::Writer::flush()
+{
+  m_stream->write(m_first, m_cur - m_first);
+  m_cur = m_first;
+}
+
+
+void Json::Writer::put(const char *data, size_t size)
+{
+  if (m_out) {
+    m_out->append(data, size);
+    return;
+  }
+
+  size_t room = m_last - m_cur;
+  if (size <= room) {
+    std::memcpy(m_cur, data, size);
+    m_cur += size;
+    return;
+  }
+
+  if (m_mode == FIXED) {
+    std::memcpy(m_cur, data, room);
+    m_cur = m_last;
+    m_pending.append(data + room, size - room);
+    return;
+  }
+
+  flush();
+  if (size >= (size_t)(m_last - m_first)) {
+    m_stream->write(data, size);
+    return;
+  }
+
+  std::memcpy(m_cur, data, size);
+  m_cur += size;
+}
+
+void Json::Writer::put_string(std::string_view str)
+{
+  static const char hex[] = "0123456789abcdef";
+
+  put('\"');
+
+  size_t run = 0;
+  for (size_t i = 0; i < str.size(); ++i) {
+    const char ch = str[i];
+
+    char esc;
+    switch (ch)
+    {
+    case '\"': esc = '\"'; break;
+    case '\\': esc = '\\'; break;
+    case '/':  esc = '/';  break;
+    case '\b': esc = 'b';  break;
+    case '\f': esc = 'f';  break;
+    case '\n': esc = 'n';  break;
+    case '\r': esc = 'r';  break;
+    case '\t': esc = 't';  break;
+    default:
+      if ((uint8_t)ch >= 0x20)
+        continue;
+      esc = 'u';
+      break;
+    }
+
+    put(str.data() + run, i - run);
+    run = i + 1;
+
+    if (esc != 'u') {
+      const char seq[2] = { '\\', esc };
+      put(seq, 2);
+    }
+    else {
+      const char seq[6] = {
+        '\\', 'u', '0', '0', hex[(uint8_t)ch >> 4], hex[(uint8_t)ch & 0xF]
+      };
+      put(seq, 6);
+    }
+  }
+  put(str.data() + run, str.size() - run);
+
+  put('\"');
+}
+
+void Json::Writer::put_scalar(const Value &val)
+{
+  switch (val.m_type)
+  {
+  case Bool:
+    put(val.m_bool ? std::string_view("true") : std::string_view("false"));
+    break;
+  case Int: {
+    char buf[Number::MaxSize];
+    put(buf, Number::Format(val.m_int, buf));
+    break;
+  }
+  case Float: {
+    if (!std::isfinite(val.m_float)) {
+      put(std::string_view("null"));
+      break;
+    }
+
+    char buf[Number::MaxSize];
+    put(buf, Number::Format(val.m_float, buf));
+    break;
+  }
+  case String:
+    put_string(*(StringType*)val.m_value);
+    break;
+  default:
+    put(std::string_view("null"));
+    break;
+  }
+}
@@ -0,0 +1,87 @@
+#ifndef SOURCE_WRITER_HPP
+#define SOURCE_WRITER_HPP
+
+
+#include "json.hpp"
+
+#include <ostream>
+#include <string_view>
+
+
+// Serializes a Value straight into its sink without intermediate strings.
+// The tree is walked with an explicit stack, so a writer over a fixed
+// buffer can stop when the buffer is full and pick up where it left off:
+//
+//   Json::Writer writer(buf, sizeof(buf));
+//   for (bool done = writer.Write(val);; done = writer.Resume()) {
+//     consume(writer.Data(), writer.Size());
+//     if (done)
+//       break;
+//   }
+//
+// A writer over a std::string appends every write to it. The value must
+// not be modified until the write completes.
+class Json::Writer
+{
+public:
+
+  Writer();
+  Writer(char *buffer, size_t size);
+  explicit Writer(std::string  &out);
+  explicit Writer(std::ostream &stream);
+
+  Writer(const Writer &writer)            = delete;
+  Writer& operator=(const Writer &writer) = delete;
+
+  bool Write (const Value &val);
+  bool Resume();
+
+  const char* Data() const;
+  size_t      Size() const;
+
+  std::string Release();
+
+private:
+
+  enum Mode
+  {
+    GROW,
+    APPEND,
+    FIXED,
+    STREAM
+  };
+
+  struct Frame
+  {
+    const Value *val;
+    size_t       i;
+  };
+
+  static constexpr size_t Open = (size_t)-1;
+
+  Mode                m_mode;
+  std::string         m_string;
+  std::string         m_pending;
+  std::string        *m_out;
+  std::ostream       *m_stream;
+  char               *m_first;
+  char               *m_cur;
+  char               *m_last;
+  std::vector<Frame>  m_stack;
+
+
+  bool run();
+  void flush();
+
+  void put       (const char *data, size_t size);
+  void put       (char ch) { put(&ch, 1); }
+  void put       (std::string_view str) { put(str.data(), str.size()); }
+  void put_string(std::string_view str);
+  void put_scalar(const Value &val);
+
+  friend class Json::Emitter;
+
+};
+
+
+#endif // !SOURCE_WRITER_HPP
@@ -0,0 +1,249 @@
+// json-cpp-test: regression checks run by ctest. Each test returns true
+// on success; failures are printed and make the exit code non-zero.
+
+#include <json.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+struct Sample
+{
+  int32_t              x = 0;
+  uint8_t              y = 0;
+  float                z = 0;
+  std::vector<Sample>  children;
+};
+JSON_CPP_BIND(Sample, x, y, z, children)
+
+
+static bool move_then_copy_assign()
+{
+  Json src;
+  if (src.LoadFromString("{\"a\":[1,2]}") != Json::ERR::SUCCESS)
+    return false;
+
+  Json dst(std::move(src));
+  Json other;
+  other.LoadFromString("[true]");
+
+  src = other;
+  if (src.Serialize() != "[true]" || dst.Serialize() != "{\"a\":[1,2]}")
+    return false;
+
+  Json moved(std::move(dst));
+  dst.Load(Json::Value(1));
+  return dst.Serialize() == "1" && moved.GetData()["a"].Size() == 2;
+}
+
+
+static bool move_from_child()
+{
+  Json json;
+  json.LoadFromString("{\"data\":{\"id\":[1,2]},\"x\":[3,{\"y\":4}]}");
+
+  Json::Value root = json.GetData();
+  root = std::move(root["data"]);
+  if (root["id"][1].GetInt() != 2 || root.Size() != 1)
+    return false;
+
+  Json::Value list = json.GetData()["x"];
+  list = std::move(list[1]);
+  if (list["y"].GetInt() != 4)
+    return false;
+
+  json.Load(std::move(json.GetData()["x"]));
+  return json.Serialize() == "[3,{\"y\":4}]";
+}
+
+static bool wide_struct_lookup()
+{
+  std::string text = "{";
+  for (int i = 0; i < 40; ++i)
+    text += (i ? ",\"k" : "\"k") + std::to_string(i) + "\":" + std::to_string(i);
+  text += "}";
+
+  Json json;
+  if (json.LoadFromString(text) != Json::ERR::SUCCESS)
+    return false;
+
+  // Const lookups from several threads build the index once.
+  const Json::Value &doc = json.GetData();
+  std::atomic<bool>        ok(true);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([&doc, &ok] {
+      for (int i = 0; i < 40; ++i)
+        if (doc["k" + std::to_string(i)].GetInt() != i)
+          ok = false;
+    });
+  for (auto &thread : threads)
+    thread.join();
+
+  Json::Value copy = doc;
+  copy["extra"] = 1;
+  copy.RemoveProperty("k0");
+  return
+    ok && !doc.Contains("extra") && copy.Contains("extra") &&
+    !copy.Contains("k0") && copy["k39"].GetInt() == 39 && copy.Size() == 40;
+}
+
+
+static std::string nested(size_t depth)
+{
+  return std::string(depth, '[') + std::string(depth, ']');
+}
+
+static bool nesting_limit()
+{
+  const std::string deep    = nested(200000);
+  const std::string limit   = nested(Json::MaxDepth);
+  const std::string too_far = nested(Json::MaxDepth + 1);
+
+  std::string log;
+  if (Json::ValidateString(deep, log) || log.find("Nesting too deep") != 0)
+    return false;
+  if (!Json::ValidateString(limit) || Json::ValidateString(too_far))
+    return false;
+
+  for (const std::string *text : { &deep, &too_far }) {
+    Json json;
+    Json::Tape tape;
+    Json::Lazy lazy;
+    Json::StreamParser stream;
+    Json::Handler handler;
+    if (
+      json.LoadFromString(*text)                             != Json::ERR::BAD_JSON ||
+      json.LoadFromString(*text, 4)                          != Json::ERR::BAD_JSON ||
+      json.LoadFromString(*text, Json::Projection{ "/0" })   != Json::ERR::BAD_JSON ||
+      Json::ParseString(*text, handler)                      != Json::ERR::BAD_JSON ||
+      tape.LoadFromString(*text)                             != Json::ERR::BAD_JSON ||
+      lazy.LoadFromString(*text)                             != Json::ERR::BAD_JSON ||
+      stream.Feed(*text)                                     != Json::ERR::BAD_JSON
+    ) {
+      return false;
+    }
+  }
+
+  Json json;
+  if (json.LoadFromString(limit) != Json::ERR::SUCCESS)
+    return false;
+
+  // 0x81 opens a one-element CBOR array, 0x91 a MessagePack one.
+  for (Json::FORMAT format : { Json::FORMAT::CBOR, Json::FORMAT::MSGPACK }) {
+    const char open = format == Json::FORMAT::CBOR ? '\x81' : '\x91';
+    Json binary;
+    if (
+      binary.LoadFromBinary(std::string(1000000, open) + '\0', format) != Json::ERR::BAD_JSON ||
+      binary.LoadFromBinary(std::string(Json::MaxDepth, open) + '\0', format) != Json::ERR::SUCCESS
+    ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+static bool bind_errors()
+{
+  Sample sample;
+  std::string log;
+  if (
+    Json::Read("{\"x\":3000000000}", sample, log) != Json::ERR::BAD_JSON ||
+    log != "Integer out of range (ln. 1, col. 6)"
+  ) {
+    return false;
+  }
+  if (
+    Json::Read("{\"y\": -1}", sample, log) != Json::ERR::BAD_JSON ||
+    log != "Integer out of range (ln. 1, col. 7)"
+  ) {
+    return false;
+  }
+
+  if (
+    Json::Read("{\"z\": 1e300}", sample, log) != Json::ERR::BAD_JSON ||
+    log != "Number out of range (ln. 1, col. 7)"
+  ) {
+    return false;
+  }
+
+  // A recursive type stops at the same depth as the parser.
+  std::string deep;
+  for (int i = 0; i < 100000; ++i)
+    deep += "{\"children\":[";
+  if (Json::Read(deep, sample, log) != Json::ERR::BAD_JSON || log.find("Nesting too deep") != 0)
+    return false;
+
+  return
+    Json::Read("{\"x\":-5,\"y\":255,\"children\":[{\"x\":1}]}", sample) == Json::ERR::SUCCESS &&
+    Json::Write(sample) == "{\"x\":-5,\"y\":255,\"z\":0.0,\"children\":[{\"x\":1,\"y\":0,\"z\":0.0,\"children\":[]}]}";
+}
+
+
+static bool projected_scalar_root()
+{
+  Json json;
+  if (json.LoadFromString("5", Json::Projection{ "/a" }) != Json::ERR::SUCCESS)
+    return false;
+  if (json.GetData().GetType() != Json::Null)
+    return false;
+
+  if (json.LoadFromString("5", Json::Projection{ "" }) != Json::ERR::SUCCESS)
+    return false;
+  if (json.GetData().GetInt() != 5)
+    return false;
+
+  return
+    json.LoadFromString("{\"a\":1,\"b\":2}", Json::Projection{ "/a" }) == Json::ERR::SUCCESS &&
+    json.Serialize() == "{\"a\":1}";
+}
+
+
+static bool binary_floats()
+{
+  Json json;
+  json.LoadFromString("[1e300,-1e300,0.5,3.4028234663852886e38,1e-320]");
+
+  for (Json::FORMAT format : { Json::FORMAT::CBOR, Json::FORMAT::MSGPACK }) {
+    Json copy;
+    if (copy.LoadFromBinary(json.SerializeBinary(format), format) != Json::ERR::SUCCESS)
+      return false;
+    if (copy.Serialize() != json.Serialize())
+      return false;
+  }
+  return true;
+}
+
+
+int main()
+{
+  struct Test
+  {
+    const char  *name;
+    bool       (*run)();
+  };
+
+  const Test tests[] = {
+    { "move_then_copy_assign", move_then_copy_assign },
+    { "move_from_child",       move_from_child       },
+    { "wide_struct_lookup",    wide_struct_lookup    },
+    { "nesting_limit",         nesting_limit         },
+    { "binary_floats",         binary_floats         },
+    { "projected_scalar_root", projected_scalar_root },
+    { "bind_errors",           bind_errors           },
+  };
+
+  int failed = 0;
+  for (const Test &test : tests) {
+    if (!test.run()) {
+      std::printf("FAILED %s\n", test.name);
+      ++failed;
+    }
+  }
+  return failed ? 1 : 0;
+}